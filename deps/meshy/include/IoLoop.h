@@ -24,6 +24,9 @@ const int MAX_RECV_BUFF = 65535;
 #ifdef OS_WIN32
 #include "iocp/iocploop.h"
 #define IoLoop IOCPLoop
+#elif defined(OS_LINUX) && defined(MESHY_IO_URING)
+#include "uring/URingLoop.h"
+#define IoLoop URingLoop
 #elif defined(OS_LINUX)
 #include "epoll/EPollLoop.h"
 #define IoLoop EPollLoop
@@ -21,7 +21,12 @@
 #include "IoLoop.h"
 #include "net.h"
 
-#ifdef OS_LINUX
+#if defined(OS_LINUX) && defined(MESHY_IO_URING)
+#include "uring/URingClient.h"
+#include "uring/URingConnection.h"
+#include "uring/URingServer.h"
+#include "uring/URingStream.h"
+#elif defined(OS_LINUX)
 #include "epoll/EPollClient.h"
 #include "epoll/EPollConnection.h"
 #include "epoll/EPollServer.h"
@@ -34,7 +39,12 @@
 #endif
 
 namespace meshy {
-#ifdef OS_LINUX
+#if defined(OS_LINUX) && defined(MESHY_IO_URING)
+    typedef URingServer TcpServer;
+    typedef URingConnection TcpConnection;
+    typedef URingClient TcpClient;
+    typedef URingStream TcpStream;
+#elif defined(OS_LINUX)
     typedef EPollServer TcpServer;
     typedef EPollConnection TcpConnection;
     typedef EPollClient TcpClient;
@@ -36,28 +36,20 @@ public:
     EPollClient(const EPollClient& client) = delete;
     virtual ~EPollClient() { }
 
-    virtual int32_t Receive(char* buffer, int32_t bufferSize, int32_t& readSize) override;
-    virtual int32_t Send(const ByteArray& byteArray) override;
-
-    uint32_t GetEvents() const {
-        return _events;
-    }
-
-    void SetEvents(uint32_t events) {
-        _events = events;
-    }
-
     void Connect(const std::string& host, int32_t port) override;
     static EPollClientPtr Connect(const std::string& ip, int32_t port, DataSink* dataSink);
+    // Connects to the unix socket of a server on the same host listening on port,
+    // returns nullptr when the server does not listen locally
+    static EPollClientPtr ConnectLocal(int32_t port, DataSink* dataSink);
 
 private:
+    // Adds the connected client to one of the loops
+    static EPollClientPtr _Attach(EPollClientPtr client);
+
     EPollClient(NativeSocket clientSocket) :
             EPollStream(clientSocket){
         this->SetNativeSocket(clientSocket);
     }
-
-private:
-    uint32_t _events;
 };
 
 
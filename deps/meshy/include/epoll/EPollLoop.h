@@ -30,6 +30,10 @@
 #include <memory>
 #include <thread>
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 #include "linux/net_linux.h"
 #include "linux/common.h"
@@ -42,12 +46,29 @@ namespace meshy {
 
     class EPollServer;
 
+    // A pool of independent loops, each running on its own thread. Every stream is pinned
+    // to the loop it was registered with, listening sockets are sharded across all loops.
     class EPollLoop : public Loop {
     public:
+        // The default loop, starting it starts every loop of the pool
         static EPollLoop* Get();
+        static EPollLoop* Get(int32_t index);
+        // Loop for a new client connection, picked round robin
+        static EPollLoop* Next();
+
+        static int32_t GetLoopCount();
+        // Has to be called before the first loop is used, 0 creates one loop per core
+        static void SetLoopCount(int32_t loopCount);
+
+        // Called on every loop thread with the index of its loop before it handles any event,
+        // for instance to pin the thread to a core. Has to be set before the loops are started.
+        typedef std::function<void(int32_t loopIndex)> ThreadStartHandler;
+        static void SetThreadStartHandler(ThreadStartHandler handler);
 
         virtual ~EPollLoop() override;
 
+        // Can be called from any thread, the loop picks the registration up before it
+        // dispatches the next events. Register before adding the fd to epoll.
         void AddServer(NativeSocket socket, EPollServer* server);
         void AddStream(EPollStreamPtr stream);
 
@@ -60,24 +81,47 @@ namespace meshy {
         virtual void _Run() override;
 
     private:
+        static std::vector<EPollLoop*>& _GetLoops();
+
         void _Initialize();
 
+        void _StartThread();
+
         void _EPollThread();
 
+        void _AddPending();
+
         void _HandleEvent(int32_t eventfd, struct epoll_event* events, int32_t nfds);
 
         int32_t _Accept(int32_t eventfd, int32_t listenfd);
 
         void _Read(int32_t eventfd, int32_t fd, uint32_t events);
 
-        void _Enqueue(EPollStreamPtr connection, const char* buf, int64_t nread);
+        void _Write(int32_t eventfd, int32_t fd);
+
+        // Removes the stream from epoll and from the loop, the socket is shut down at once
+        // and closed with the last reference to the stream
+        void _Close(int32_t fd);
+
+        void _Enqueue(EPollStream* connection, const char* buf, int64_t nread);
 
     private:
         int32_t _eventfd;
         bool _shutdown;
+        std::atomic<bool> _started;
+
+        static int32_t _loopCount;
+        static ThreadStartHandler _threadStartHandler;
+
+        // Indexed by fd and only touched by the loop thread
+        std::vector<EPollServer*> _servers;
+        std::vector<EPollStreamPtr> _streams;
 
-        std::map<NativeSocket, EPollServer*> _servers;
-        std::map <NativeSocket, EPollStreamPtr> _streams;
+        // Registrations waiting for the loop thread
+        std::mutex _pendingMutex;
+        std::atomic<bool> _hasPending;
+        std::vector<std::pair<NativeSocket, EPollServer*>> _pendingServers;
+        std::vector<EPollStreamPtr> _pendingStreams;
     };
 }
 
@@ -23,15 +23,22 @@
 #include "PackageDataSink.h"
 #include "epoll/EPollConnection.h"
 
+#include <map>
+
 
 namespace meshy {
 
+    class EPollLoop;
+
     class EPollServer : public BasicServer<EPollConnectionPtr> {
     public:
-        EPollServer() { }
-        virtual ~EPollServer() { }
+        EPollServer() : _localListenfd(-1) { }
+        virtual ~EPollServer();
 
         int32_t Listen(const std::string& host, int32_t port, int32_t backlog = 20) override;
+        // Also listens on the unix socket clients on the same host reach port through,
+        // see EPollClient::ConnectLocal
+        int32_t ListenLocal(int32_t port, int32_t backlog = 20);
 
         void OnConnectIndication(ConnectIndicationHandler handler) {
             _connectHandler = handler;
@@ -40,14 +47,20 @@ namespace meshy {
             _disconnectIndication = handler;
         }
 
-        EPollConnectionPtr Accept(int32_t sockfd);
+        // Accepts a connection on one of the listening sockets, the connection is pinned
+        // to the loop that socket belongs to
+        EPollConnectionPtr Accept(int32_t listenfd);
 
     private:
-        int32_t _Bind(const std::string& host, int32_t port);
+        int32_t _Bind(const std::string& host, int32_t port, bool reusePort);
 
         DataSink* _dataSink;
         ConnectIndicationHandler _connectHandler;
         DisconnectIndicationHandler _disconnectIndication;
+        // One listening socket per loop, the first one is the native socket of the server
+        std::map<NativeSocket, EPollLoop*> _listenLoops;
+        // Its connections are spread over the loops in turn
+        NativeSocket _localListenfd;
     };
 
 }
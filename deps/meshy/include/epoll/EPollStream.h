@@ -27,6 +27,10 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <sys/epoll.h>
+#include <deque>
+#include <mutex>
+#include <vector>
 #include "linux/net_linux.h"
 #include "net.h"
 
@@ -37,14 +41,51 @@ namespace meshy {
     class EPollStream : public BasicStream {
     public:
         EPollStream(NativeSocket nativeSocket) :
-                BasicStream(nativeSocket) {}
+                BasicStream(nativeSocket), _events(EPOLLIN | EPOLLET), _loop(nullptr),
+                _sendOffset(0), _sendQueueSize(0), _receivingPaused(false) {}
 
         virtual ~EPollStream() { }
 
         EPollStream(const EPollStream &stream) = delete;
 
         virtual int32_t Receive(char *buffer, int32_t bufferSize, int32_t &readSize) override;
+        // Reads into the receive buffer of the stream until the socket would block or the
+        // buffer reached RECV_BUFF_LIMIT, the data stays at GetReceivedData() until the next call.
+        // Returns the last readv result, a positive value means more data may be pending.
+        int32_t ReceiveBuffered(int32_t &readSize);
+
+        const char* GetReceivedData() const {
+            return _receiveBuffer.data();
+        }
+
+        // Writes as much as the socket accepts and queues the rest, the queue is written
+        // by the loop once the socket becomes writable again
         virtual int32_t Send(const ByteArray &byteArray) override;
+        // Only the part the socket did not accept is copied
+        virtual int32_t Send(const char *buffer, int32_t size) override;
+        // Called by the loop on EPOLLOUT
+        int32_t Flush();
+
+        // Bytes and buffers waiting for the socket, callers use them to apply backpressure
+        size_t GetSendQueueSize() const {
+            std::unique_lock<std::mutex> locker(_sendMutex);
+            return _sendQueueSize;
+        }
+
+        size_t GetSendQueueLength() const {
+            std::unique_lock<std::mutex> locker(_sendMutex);
+            return _sendQueue.size();
+        }
+
+        // EPOLLIN is removed while paused, the loop stops draining the socket
+        virtual void PauseReceiving() override;
+        // Arming EPOLLIN again makes epoll report the data left in the socket
+        virtual void ResumeReceiving() override;
+
+        bool IsReceivingPaused() const {
+            std::unique_lock<std::mutex> locker(_sendMutex);
+            return _receivingPaused;
+        }
 
         uint32_t GetEvents() const {
             return _events;
@@ -54,6 +95,15 @@ namespace meshy {
             _events = events;
         }
 
+        // The loop the stream is registered with for its whole lifetime
+        EPollLoop* GetLoop() const {
+            return _loop;
+        }
+
+        void SetLoop(EPollLoop* loop) {
+            _loop = loop;
+        }
+
         void OnDataIndication(DataIndicationHandler handler) override {
             _dataHandler = handler;
         }
@@ -62,8 +112,21 @@ namespace meshy {
         }
 
     private:
+        int32_t _FlushSendQueue();
+
         uint32_t _events;
+        EPollLoop* _loop;
         DataIndicationHandler _dataHandler;
+
+        // Reused by every read, grows with the bursts it has to hold
+        std::vector<char> _receiveBuffer;
+
+        mutable std::mutex _sendMutex;
+        std::deque<ByteArray> _sendQueue;
+        // Bytes of the first queued buffer which have been written already
+        size_t _sendOffset;
+        size_t _sendQueueSize;
+        bool _receivingPaused;
     };
 
     typedef std::shared_ptr <EPollStream> EPollStreamPtr;
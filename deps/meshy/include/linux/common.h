@@ -21,5 +21,12 @@
 
 #define MAX_EVENT_COUNT   32000
 #define MAX_RECV_BUFF     65535
+#define RECV_BUFF_LIMIT   (16 * 1024 * 1024)
+#define MAX_SEND_IOV      64
+
+// io_uring backend: submission queue size and the receive buffers provided to each ring
+#define URING_ENTRIES       4096
+#define URING_BUFFER_COUNT  256
+#define URING_BUFFER_SIZE   16384
 
 #endif //NET_FRAME_COMMON_H
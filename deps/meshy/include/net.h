@@ -74,6 +74,10 @@ namespace meshy {
 
 		virtual int32_t Receive(char* buffer, int32_t bufferSize, int32_t& readSize) = 0;
 		virtual int32_t Send(const ByteArray& byteArray) = 0;
+		// Streams which write the caller's buffer without copying it first override this
+		virtual int32_t Send(const char* buffer, int32_t size) {
+			return Send(ByteArray(buffer, size));
+		}
 
         virtual void OnDataIndication(DataIndicationHandler handler) = 0;
         virtual DataIndicationHandler GetDataIndication() = 0;
@@ -101,6 +105,8 @@ namespace meshy {
 
     class BasicStream : public IStream, public Socket {
     public:
+        typedef std::function<void()> CloseIndicationHandler;
+
         BasicStream() = default;
         BasicStream(NativeSocket nativeSocket) : Socket(nativeSocket) {}
 
@@ -118,7 +124,23 @@ namespace meshy {
             return _dataSink;
         }
 
+        // Called on the loop thread once the peer closed the stream or it failed,
+        // nothing is received afterwards
+        void OnCloseIndication(CloseIndicationHandler handler) {
+            _closeHandler = handler;
+        }
+        const CloseIndicationHandler& GetCloseIndication() const {
+            return _closeHandler;
+        }
+
+        // Stops reading the socket until ResumeReceiving, a peer which keeps sending is then
+        // held back by the socket buffers. Can be called from any thread, streams which cannot
+        // pause keep receiving.
+        virtual void PauseReceiving() {}
+        virtual void ResumeReceiving() {}
+
     private:
         DataSink* _dataSink;
+        CloseIndicationHandler _closeHandler;
     };
 }
@@ -0,0 +1,76 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#ifndef NET_FRAMEWORK_URING_H
+#define NET_FRAMEWORK_URING_H
+
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <cstddef>
+
+namespace meshy {
+
+    // Thin wrapper over the raw io_uring system calls. A ring is only used by the thread
+    // of the loop owning it, entries are prepared one by one and submitted in one call.
+    class URing {
+    public:
+        URing();
+        ~URing();
+
+        URing(const URing& ring) = delete;
+
+        int32_t Initialize(uint32_t entries);
+
+        // Returns nullptr when the submission queue is full, Submit() makes room again
+        struct io_uring_sqe* GetSubmission();
+        // Submits every prepared entry and waits until at least waitCount completions are ready
+        int32_t Submit(uint32_t waitCount);
+
+        // Returns nullptr when no completion is ready, SeenCompletion() releases the returned one
+        struct io_uring_cqe* PeekCompletion();
+        void SeenCompletion();
+
+        // Buffers the kernel picks from for requests flagged with IOSQE_BUFFER_SELECT
+        int32_t RegisterBufferRing(struct io_uring_buf_ring* bufferRing, uint32_t entries, uint16_t groupId);
+
+    private:
+        int32_t _ringfd;
+
+        void* _submissionRing;
+        size_t _submissionRingSize;
+        void* _completionRing;
+        size_t _completionRingSize;
+
+        uint32_t* _submissionHead;
+        uint32_t* _submissionTail;
+        uint32_t _submissionMask;
+        uint32_t _submissionEntries;
+        struct io_uring_sqe* _submissions;
+        size_t _submissionsSize;
+        // Entries handed out by GetSubmission() but not submitted yet
+        uint32_t _preparedTail;
+
+        uint32_t* _completionHead;
+        uint32_t* _completionTail;
+        uint32_t _completionMask;
+        struct io_uring_cqe* _completions;
+    };
+
+}
+
+#endif //NET_FRAMEWORK_URING_H
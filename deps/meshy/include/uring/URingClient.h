@@ -0,0 +1,57 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#ifndef NET_FRAMEWORK_URINGCLIENT_H
+#define NET_FRAMEWORK_URINGCLIENT_H
+
+#include "uring/URingStream.h"
+#include "net.h"
+#include "DataSink.h"
+
+#include <memory>
+
+namespace meshy {
+
+    class URingClient;
+
+    typedef std::shared_ptr<URingClient> URingClientPtr;
+
+    class URingClient : public URingStream, public IConnectable {
+    public:
+        URingClient(const URingClient& client) = delete;
+        virtual ~URingClient() { }
+
+        // Connects synchronously, the socket stays blocking since io_uring waits on it
+        void Connect(const std::string& host, int32_t port) override;
+        static URingClientPtr Connect(const std::string& ip, int32_t port, DataSink* dataSink);
+        // Connects to the unix socket of a server on the same host listening on port,
+        // returns nullptr when the server does not listen locally
+        static URingClientPtr ConnectLocal(int32_t port, DataSink* dataSink);
+
+    private:
+        // Adds the connected client to one of the loops
+        static URingClientPtr _Attach(URingClientPtr client);
+
+        URingClient(NativeSocket clientSocket) :
+                URingStream(clientSocket) {
+        }
+    };
+
+}
+
+#endif //NET_FRAMEWORK_URINGCLIENT_H
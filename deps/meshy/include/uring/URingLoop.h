@@ -0,0 +1,169 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#ifndef NET_FRAMEWORK_URINGLOOP_H
+#define NET_FRAMEWORK_URINGLOOP_H
+
+#include "loop.h"
+#include "uring/URing.h"
+#include "uring/URingConnection.h"
+#include "uring/URingStream.h"
+#include "uring/URingServer.h"
+#include "uring/URingClient.h"
+#include "net.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+#include "linux/net_linux.h"
+#include "linux/common.h"
+
+
+namespace meshy {
+
+    class URingServer;
+
+    // io_uring counterpart of EPollLoop. Every loop owns a ring which only its thread submits
+    // to: listening sockets use multishot accepts, streams keep a multishot receive armed on
+    // buffers provided to the ring, and all sends prepared during one pass are submitted
+    // together with a single io_uring_enter.
+    class URingLoop : public Loop {
+    public:
+        // The default loop, starting it starts every loop of the pool
+        static URingLoop* Get();
+        static URingLoop* Get(int32_t index);
+        // Loop for a new client connection, picked round robin
+        static URingLoop* Next();
+
+        static int32_t GetLoopCount();
+        // Has to be called before the first loop is used, 0 creates one loop per core
+        static void SetLoopCount(int32_t loopCount);
+
+        // Called on every loop thread with the index of its loop before it handles any event,
+        // for instance to pin the thread to a core. Has to be set before the loops are started.
+        typedef std::function<void(int32_t loopIndex)> ThreadStartHandler;
+        static void SetThreadStartHandler(ThreadStartHandler handler);
+
+        virtual ~URingLoop() override;
+
+        // Can be called from any thread, the loop picks the registration up on its next pass
+        void AddServer(NativeSocket socket, URingServer* server);
+        void AddStream(URingStreamPtr stream);
+        // Called by a stream whose send queue was empty
+        void ScheduleSend(NativeSocket fd);
+        // Called by a stream which paused or resumed receiving
+        void ScheduleReceive(NativeSocket fd);
+
+    protected:
+        URingLoop();
+
+        virtual void _Run() override;
+
+    private:
+        struct Operation {
+            enum Values {
+                Accept,
+                Receive,
+                Send,
+                Wakeup,
+                Cancel
+            };
+        };
+
+        struct Completion {
+            uint64_t userData;
+            int32_t result;
+            uint32_t flags;
+        };
+
+        static std::vector<URingLoop*>& _GetLoops();
+
+        void _Initialize();
+
+        void _StartThread();
+
+        void _URingThread();
+
+        void _Wakeup();
+
+        void _AddPending();
+
+        struct io_uring_sqe* _GetSubmission(Operation::Values operation, NativeSocket fd);
+
+        void _SubmitAccept(NativeSocket listenfd);
+
+        void _SubmitReceive(URingStream* stream);
+
+        void _SubmitSend(URingStream* stream);
+
+        void _SubmitWakeup();
+
+        void _SubmitCancel(URingStream* stream);
+
+        // Cancels or arms the receive request to match the paused state of the stream
+        void _UpdateReceive(URingStream* stream);
+
+        void _HandleCompletion(uint64_t userData, int32_t result, uint32_t flags);
+
+        void _Accept(NativeSocket listenfd, int32_t result, uint32_t flags);
+
+        void _Read(NativeSocket fd, int32_t result, uint32_t flags);
+
+        void _Write(NativeSocket fd, int32_t result);
+
+        void _Close(URingStream* stream);
+
+        void _RecycleBuffer(uint16_t bufferId);
+
+    private:
+        URing _ring;
+        bool _shutdown;
+        std::atomic<bool> _started;
+
+        static int32_t _loopCount;
+        static ThreadStartHandler _threadStartHandler;
+
+        // Other threads wake the loop through this eventfd, a read on it is always pending
+        int32_t _wakeupfd;
+        uint64_t _wakeupValue;
+        std::atomic<bool> _wakeupPending;
+
+        // Receive buffers provided to the ring, the kernel picks one for every receive
+        struct io_uring_buf_ring* _bufferRing;
+        char* _buffers;
+        uint16_t _bufferTail;
+
+        // Indexed by fd and only touched by the loop thread
+        std::vector<URingServer*> _servers;
+        std::vector<URingStreamPtr> _streams;
+        // Reaped while a submission waited for room in the ring, handled on the next pass
+        std::vector<Completion> _deferredCompletions;
+
+        // Registrations and sends waiting for the loop thread
+        std::mutex _pendingMutex;
+        std::vector<std::pair<NativeSocket, URingServer*>> _pendingServers;
+        std::vector<URingStreamPtr> _pendingStreams;
+        std::vector<NativeSocket> _pendingSends;
+        std::vector<NativeSocket> _pendingReceives;
+    };
+}
+
+#endif //NET_FRAMEWORK_URINGLOOP_H
@@ -0,0 +1,66 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#ifndef NET_FRAMEWORK_URINGSERVER_H
+#define NET_FRAMEWORK_URINGSERVER_H
+
+#include "net.h"
+#include "uring/URingConnection.h"
+
+#include <map>
+
+
+namespace meshy {
+
+    class URingLoop;
+
+    class URingServer : public BasicServer<URingConnectionPtr> {
+    public:
+        URingServer() : _localListenfd(-1) { }
+        virtual ~URingServer();
+
+        int32_t Listen(const std::string& host, int32_t port, int32_t backlog = 20) override;
+        // Also listens on the unix socket clients on the same host reach port through,
+        // see URingClient::ConnectLocal
+        int32_t ListenLocal(int32_t port, int32_t backlog = 20);
+
+        void OnConnectIndication(ConnectIndicationHandler handler) {
+            _connectHandler = handler;
+        }
+        void OnDisconnectIndication(DisconnectIndicationHandler handler) {
+            _disconnectIndication = handler;
+        }
+
+        // Accepts one connection synchronously, the loops accept through multishot requests
+        URingConnectionPtr Accept(int32_t listenfd) override;
+        // Wraps a socket accepted on listenfd, the connection is pinned to the loop of that socket
+        URingConnectionPtr Attach(int32_t listenfd, NativeSocket connectionSocket);
+
+    private:
+        int32_t _Bind(const std::string& host, int32_t port, bool reusePort);
+
+        ConnectIndicationHandler _connectHandler;
+        DisconnectIndicationHandler _disconnectIndication;
+        // One listening socket per loop, the first one is the native socket of the server
+        std::map<NativeSocket, URingLoop*> _listenLoops;
+        // Its connections are spread over the loops in turn
+        NativeSocket _localListenfd;
+    };
+
+}
+#endif //NET_FRAMEWORK_URINGSERVER_H
@@ -0,0 +1,117 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#ifndef NET_FRAMEWORK_URINGSTREAM_H
+#define NET_FRAMEWORK_URINGSTREAM_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include "linux/net_linux.h"
+#include "linux/common.h"
+#include "net.h"
+
+
+namespace meshy {
+    class URingLoop;
+
+    class URingStream : public BasicStream {
+    public:
+        URingStream(NativeSocket nativeSocket) :
+                BasicStream(nativeSocket), _loop(nullptr), _sendOffset(0), _sendQueueSize(0),
+                _sendScheduled(false), _closed(false), _receivingPaused(false), _receiving(false),
+                _sending(false) {}
+
+        virtual ~URingStream() { }
+
+        URingStream(const URingStream &stream) = delete;
+
+        // Data normally arrives through the data indication, the loop keeps a receive
+        // request armed for every stream
+        virtual int32_t Receive(char *buffer, int32_t bufferSize, int32_t &readSize) override;
+        // Queues the data, the loop writes everything queued in one submission
+        virtual int32_t Send(const ByteArray &byteArray) override;
+        virtual int32_t Send(const char *buffer, int32_t size) override;
+
+        // The loop cancels the receive request and arms it again on resume, buffers the kernel
+        // filled before the cancellation are still delivered
+        virtual void PauseReceiving() override;
+        virtual void ResumeReceiving() override;
+
+        size_t GetSendQueueSize() const {
+            std::unique_lock<std::mutex> locker(_sendMutex);
+            return _sendQueueSize;
+        }
+
+        size_t GetSendQueueLength() const {
+            std::unique_lock<std::mutex> locker(_sendMutex);
+            return _sendQueue.size();
+        }
+
+        // The loop the stream is registered with for its whole lifetime
+        URingLoop* GetLoop() const {
+            return _loop;
+        }
+
+        void SetLoop(URingLoop* loop) {
+            _loop = loop;
+        }
+
+        void OnDataIndication(DataIndicationHandler handler) override {
+            _dataHandler = handler;
+        }
+        DataIndicationHandler GetDataIndication() override {
+            return _dataHandler;
+        }
+
+    private:
+        friend class URingLoop;
+
+        // Called by the loop, fills the message of the next send submission
+        struct msghdr* _PrepareSend();
+        // Called by the loop, drops what the kernel wrote and tells whether anything is left
+        bool _CompleteSend(size_t written);
+        void _Close();
+
+        URingLoop* _loop;
+        DataIndicationHandler _dataHandler;
+
+        mutable std::mutex _sendMutex;
+        std::deque<ByteArray> _sendQueue;
+        // Bytes of the first queued buffer which have been written already
+        size_t _sendOffset;
+        size_t _sendQueueSize;
+        // The loop has been asked to send and has not drained the queue yet
+        bool _sendScheduled;
+        bool _closed;
+        std::atomic<bool> _receivingPaused;
+
+        // Only touched by the loop thread
+        bool _receiving;
+        bool _sending;
+        struct iovec _sendVectors[MAX_SEND_IOV];
+        struct msghdr _sendMessage;
+    };
+
+    typedef std::shared_ptr <URingStream> URingStreamPtr;
+}
+
+#endif //NET_FRAMEWORK_URINGSTREAM_H
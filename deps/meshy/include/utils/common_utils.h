@@ -25,11 +25,30 @@
 
 #include <fcntl.h>
 #include <cstdint>
+#include <string>
+
+#ifdef OS_LINUX
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 
 namespace meshy {
 
     int32_t SetNonBlocking(int32_t sockfd);
 
+#ifdef OS_LINUX
+    // Disables Nagle's algorithm so that small writes leave at once, only applies to tcp sockets
+    int32_t SetNoDelay(int32_t sockfd, bool noDelay);
+#endif
+
+#ifdef OS_LINUX
+    // True when host is a loopback address or one of the addresses of this machine
+    bool IsLocalHost(const std::string& host);
+    // Fills the abstract unix socket address a server listening on port is also reachable on
+    // from the same host, returns the length of the address
+    socklen_t GetLocalAddress(int32_t port, struct sockaddr_un* address);
+#endif
+
 }
 
 #endif //NET_FRAMEWORK_COMMON_UTILS_H_H
@@ -45,59 +45,45 @@ namespace meshy {
         client->SetDataSink(dataSink);
         client->Connect(ip, port);
 
-        // TODO: Add to epoll loop
-        EPollLoop *ePollLoop = EPollLoop::Get();
+        return _Attach(client);
+    }
 
-        client->_events = EPOLLIN | EPOLLET;
-        if ( ePollLoop->AddEpollEvents(client->_events, clientSocket) == -1 ) {
-            perror("epoll_ctl: add");
-            exit(EXIT_FAILURE);
+    EPollClientPtr EPollClient::ConnectLocal(int32_t port, DataSink* dataSink) {
+        int32_t clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ( clientSocket < 0 ) {
+            return EPollClientPtr(nullptr);
         }
 
-        ePollLoop->AddStream(client);
-
-        return client;
-    }
+        // A unix socket connects at once, so a missing listener is known right away
+        struct sockaddr_un serv_addr;
+        socklen_t addrlen = GetLocalAddress(port, &serv_addr);
+        if ( connect(clientSocket, (struct sockaddr *) &serv_addr, addrlen) < 0 ) {
+            close(clientSocket);
+            return EPollClientPtr(nullptr);
+        }
 
-    int32_t EPollClient::Receive(char *buffer, int32_t bufferSize, int32_t &readSize) {
-        readSize = 0;
-        int32_t nread = 0;
-        NativeSocketEvent ev;
+        meshy::SetNonBlocking(clientSocket);
 
-        while ((nread = read(GetNativeSocket(), buffer + readSize, bufferSize - 1)) > 0) {
-            readSize += nread;
-        }
+        EPollClientPtr client = EPollClientPtr(new EPollClient(clientSocket));
+        client->SetDataSink(dataSink);
 
-        return nread;
+        return _Attach(client);
     }
 
-    int32_t EPollClient::Send(const meshy::ByteArray& byteArray) {
-        TRACE_DEBUG("EPollConnection::Send");
+    EPollClientPtr EPollClient::_Attach(EPollClientPtr client) {
+        NativeSocket clientSocket = client->GetNativeSocket();
 
-        struct epoll_event ev;
-        NativeSocket clientSocket = GetNativeSocket();
+        EPollLoop *ePollLoop = EPollLoop::Next();
+        client->SetLoop(ePollLoop);
 
-        if ( EPollLoop::Get()->ModifyEpollEvents(_events | EPOLLOUT, clientSocket) ) {
-            // TODO: MARK ERASE
-            TRACE_ERROR("FATAL epoll_ctl: mod failed!");
-        }
+        client->SetEvents(EPOLLIN | EPOLLET);
+        ePollLoop->AddStream(client);
 
-        const char *buf = byteArray.data();
-        int32_t size = byteArray.size();
-        int32_t n = size;
-
-        while (n > 0) {
-            int32_t nwrite;
-            nwrite = write(clientSocket, buf + size - n, n);
-            if (nwrite < n) {
-                if (nwrite == -1 && errno != EAGAIN) {
-                    TRACE_ERROR("FATAL write data to peer failed!");
-                }
-                break;
-            }
-            n -= nwrite;
+        if ( ePollLoop->AddEpollEvents(client->GetEvents(), clientSocket) == -1 ) {
+            perror("epoll_ctl: add");
+            exit(EXIT_FAILURE);
         }
 
-        return 0;
+        return client;
     }
 }
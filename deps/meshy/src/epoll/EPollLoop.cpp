@@ -20,17 +20,67 @@
 #include "utils/logger.h"
 #include <signal.h>
 #include <cassert>
+#include <algorithm>
 
 namespace meshy {
     using namespace std::placeholders;
 
+    int32_t EPollLoop::_loopCount = 0;
+    EPollLoop::ThreadStartHandler EPollLoop::_threadStartHandler;
+
     EPollLoop* EPollLoop::Get()
 	{
-        static EPollLoop epollLoop;
-        return &epollLoop;
+        return _GetLoops()[0];
+    }
+
+    EPollLoop* EPollLoop::Get(int32_t index)
+    {
+        return _GetLoops()[index];
+    }
+
+    EPollLoop* EPollLoop::Next()
+    {
+        static std::atomic<uint32_t> nextLoop(0);
+        std::vector<EPollLoop*>& loops = _GetLoops();
+
+        return loops[nextLoop ++ % loops.size()];
+    }
+
+    int32_t EPollLoop::GetLoopCount()
+    {
+        return int32_t(_GetLoops().size());
+    }
+
+    void EPollLoop::SetLoopCount(int32_t loopCount)
+    {
+        _loopCount = loopCount;
+    }
+
+    void EPollLoop::SetThreadStartHandler(ThreadStartHandler handler)
+    {
+        _threadStartHandler = handler;
     }
 
-    EPollLoop::EPollLoop()
+    std::vector<EPollLoop*>& EPollLoop::_GetLoops()
+    {
+        static std::vector<EPollLoop*> loops = [] {
+            int32_t loopCount = _loopCount;
+            if ( loopCount <= 0 ) {
+                loopCount = std::max(int32_t(std::thread::hardware_concurrency()), 1);
+            }
+
+            std::vector<EPollLoop*> createdLoops;
+            for ( int32_t loopIndex = 0; loopIndex < loopCount; loopIndex ++ ) {
+                createdLoops.push_back(new EPollLoop);
+            }
+
+            return createdLoops;
+        }();
+
+        return loops;
+    }
+
+    EPollLoop::EPollLoop() : _shutdown(false), _started(false), _hasPending(false)
 	{
         TRACE_DEBUG("EPollLoop::EPollLoop");
 
@@ -50,12 +100,41 @@ namespace meshy {
 	
 	void EPollLoop::AddServer(NativeSocket socket, EPollServer* server)
 	{
-        _servers.insert({socket, server});
+        std::lock_guard<std::mutex> locker(_pendingMutex);
+        _pendingServers.push_back({socket, server});
+        _hasPending = true;
     }
 
     void EPollLoop::AddStream(EPollStreamPtr stream)
     {
-        _streams[stream->GetNativeSocket()] = stream;
+        std::lock_guard<std::mutex> locker(_pendingMutex);
+        _pendingStreams.push_back(stream);
+        _hasPending = true;
+    }
+
+    void EPollLoop::_AddPending()
+    {
+        std::lock_guard<std::mutex> locker(_pendingMutex);
+        _hasPending = false;
+
+        for ( auto& pendingServer : _pendingServers ) {
+            if ( pendingServer.first >= NativeSocket(_servers.size()) ) {
+                _servers.resize(pendingServer.first + 1);
+            }
+
+            _servers[pendingServer.first] = pendingServer.second;
+        }
+        _pendingServers.clear();
+
+        for ( EPollStreamPtr& pendingStream : _pendingStreams ) {
+            NativeSocket fd = pendingStream->GetNativeSocket();
+            if ( fd >= NativeSocket(_streams.size()) ) {
+                _streams.resize(fd + 1);
+            }
+
+            _streams[fd] = std::move(pendingStream);
+        }
+        _pendingStreams.clear();
     }
 
     int32_t EPollLoop::AddEpollEvents(int32_t events, int32_t fd)
@@ -87,6 +166,24 @@ namespace meshy {
 
     void EPollLoop::_Run()
 	{
+        // Callers only know the default loop
+        if ( this == Get() ) {
+            for ( EPollLoop* loop : _GetLoops() ) {
+                loop->_StartThread();
+            }
+        }
+        else {
+            _StartThread();
+        }
+    }
+
+    void EPollLoop::_StartThread()
+    {
+        bool started = false;
+        if ( !_started.compare_exchange_strong(started, true) ) {
+            return;
+        }
+
         auto func = std::bind(&EPollLoop::_EPollThread, this);
         std::thread listenThread(func);
         listenThread.detach();
@@ -95,6 +192,11 @@ namespace meshy {
     void EPollLoop::_EPollThread()
 	{
         TRACE_DEBUG("_EPollThread");
+
+        if ( _threadStartHandler ) {
+            std::vector<EPollLoop*>& loops = _GetLoops();
+            _threadStartHandler(int32_t(std::find(loops.begin(), loops.end(), this) - loops.begin()));
+        }
         NativeSocketEvent events[MAX_EVENT_COUNT];
 
         while (!_shutdown) {
@@ -111,21 +213,31 @@ namespace meshy {
 
     void EPollLoop::_HandleEvent(int32_t eventfd, NativeSocketEvent* events, int32_t nfds)
 	{
+        // Every fd in this batch has been registered before it was added to epoll
+        if ( _hasPending ) {
+            _AddPending();
+        }
+
         for (int i = 0; i < nfds; ++i) {
             int32_t fd;
             fd = events[i].data.fd;
 
-            if (_servers.find(fd) != _servers.end()) {
+            if (fd < int32_t(_servers.size()) && _servers[fd]) {
                 _Accept(eventfd, fd);
                 continue;
             }
 
-            int32_t n = 0;
             if (events[i].events & EPOLLIN) {
                 _Read(eventfd, fd, events[i].events);
             }
 
             if (events[i].events & EPOLLOUT) {
+                _Write(eventfd, fd);
+            }
+
+            // The data which arrived before the hang up has been read above
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                _Close(fd);
             }
         }
     }
@@ -133,41 +245,82 @@ namespace meshy {
     int32_t EPollLoop::_Accept(int32_t eventfd, int32_t listenfd)
 	{
         TRACE_DEBUG("_Accept");
-        EPollServer* server = _servers.find(listenfd)->second;
-        EPollConnectionPtr connection = server->Accept(eventfd);
-
-        if (connection != nullptr) {
-            _streams[connection->GetNativeSocket()] = connection;
-        }
+        EPollServer* server = _servers[listenfd];
+        server->Accept(listenfd);
     }
 
     void EPollLoop::_Read(int32_t eventfd, int32_t fd, uint32_t events)
 	{
         TRACE_DEBUG("_Read");
 
-        EPollStreamPtr stream = _streams[fd];
+        if ( fd >= int32_t(_streams.size()) || !_streams[fd] ) {
+            return;
+        }
 
-        char buffer[BUFSIZ];
-        int32_t readSize;
-        int32_t nread = stream->Receive(buffer, BUFSIZ, readSize);
+        EPollStream* stream = _streams[fd].get();
 
-        stream->SetEvents(events);
+        // Edge triggered, the socket has to be drained. Every chunk is handed to the
+        // stream handler straight from the receive buffer of the stream.
+        int32_t readSize;
+        int32_t nread;
+        int32_t error;
+        do {
+            nread = stream->ReceiveBuffered(readSize);
+            error = errno;
+
+            if (readSize > 0) {
+                _Enqueue(stream, stream->GetReceivedData(), readSize);
+            }
+        } while (nread > 0 && !stream->IsReceivingPaused());
 
-        if ((nread == -1 && errno != EAGAIN) || readSize == 0) {
-            _streams.erase(fd);
+        // Paused by the handler, the rest is read once the stream resumes
+        if (nread > 0) {
+            return;
+        }
 
+        if (nread == 0 || (error != EAGAIN && error != EWOULDBLOCK)) {
             // Print error message
             char message[50];
-            sprintf(message, "errno: %d: %s, nread: %d, n: %d", errno, strerror(errno), nread, readSize);
+            sprintf(message, "errno: %d: %s, nread: %d, n: %d", error, strerror(error), nread, readSize);
             TRACE_WARNING(message);
+
+            _Close(fd);
+            return;
+        }
+    }
+
+    void EPollLoop::_Write(int32_t eventfd, int32_t fd)
+	{
+        TRACE_DEBUG("_Write");
+
+        if ( fd >= int32_t(_streams.size()) || !_streams[fd] ) {
             return;
         }
 
-        // Write buf to the receive queue.
-        _Enqueue(stream, buffer, readSize);
+        if (_streams[fd]->Flush() < 0) {
+            _Close(fd);
+        }
+    }
+
+    void EPollLoop::_Close(int32_t fd)
+    {
+        if ( fd >= int32_t(_streams.size()) || !_streams[fd] ) {
+            return;
+        }
+
+        EPollStreamPtr stream = std::move(_streams[fd]);
+        epoll_ctl(_eventfd, EPOLL_CTL_DEL, fd, nullptr);
+
+        // The owner of a client stream may still be sending on another thread, closing the fd
+        // here could let those writes reach a new socket with the same number
+        shutdown(fd, SHUT_RDWR);
+
+        if ( stream->GetCloseIndication() ) {
+            stream->GetCloseIndication()();
+        }
     }
 
-    void EPollLoop::_Enqueue(EPollStreamPtr stream, const char* buf, int64_t nread)
+    void EPollLoop::_Enqueue(EPollStream* stream, const char* buf, int64_t nread)
 	{
         TRACE_DEBUG("_Enqueue");
 
@@ -33,17 +33,35 @@
 #endif
 
 namespace meshy {
-    int32_t EPollServer::_Bind(const std::string& host, int32_t port) {
+    EPollServer::~EPollServer() {
+        for ( auto& listenLoop : _listenLoops ) {
+            if ( listenLoop.first != GetNativeSocket() ) {
+                close(listenLoop.first);
+            }
+        }
+
+        if ( _localListenfd >= 0 ) {
+            close(_localListenfd);
+        }
+    }
+
+    int32_t EPollServer::_Bind(const std::string& host, int32_t port, bool reusePort) {
         int32_t listenfd;
         if ((listenfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
             TRACE_ERROR("Create socket failed!");
             exit(1);
         }
 
-        SetNativeSocket(listenfd);
         int32_t option = 1;
         setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
 
+        // Lets every loop listen on the same address, the kernel spreads the connections
+        if (reusePort && setsockopt(listenfd, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) < 0) {
+            TRACE_WARNING("SO_REUSEPORT is not supported!");
+            close(listenfd);
+            return -1;
+        }
+
         // make socket non-blocking
         meshy::SetNonBlocking(listenfd);
 
@@ -57,59 +75,122 @@ namespace meshy {
         if (errorCode < 0) {
             TRACE_ERROR("Bind socket failed!");
             assert(0);
+            close(listenfd);
             return errorCode;
         }
 		
-		return 0;
+		return listenfd;
     }
 
     int32_t EPollServer::Listen(const std::string& host, int32_t port, int32_t backlog) {
-        _Bind(host, port);
+        int32_t loopCount = EPollLoop::GetLoopCount();
+
+        for (int32_t loopIndex = 0; loopIndex < loopCount; ++ loopIndex) {
+            int32_t listenfd = _Bind(host, port, loopCount > 1);
+            if (listenfd < 0) {
+                // Without SO_REUSEPORT the first socket serves every connection
+                if (loopIndex > 0) {
+                    break;
+                }
+
+                listenfd = _Bind(host, port, false);
+                if (listenfd < 0) {
+                    return listenfd;
+                }
+                loopCount = 1;
+            }
 
-        int32_t listenfd = GetNativeSocket();
+            if (loopIndex == 0) {
+                SetNativeSocket(listenfd);
+            }
 
-        int32_t errorCode = listen(listenfd, backlog);
-        if (-1 == errorCode) {
-            TRACE_ERROR("Listen socket failed!");
-            assert(0);
-            return errorCode;
+            int32_t errorCode = listen(listenfd, backlog);
+            if (-1 == errorCode) {
+                TRACE_ERROR("Listen socket failed!");
+                assert(0);
+                return errorCode;
+            }
+
+            _listenLoops[listenfd] = EPollLoop::Get(loopIndex);
         }
 
-        errorCode = EPollLoop::Get()->AddEpollEvents(EPOLLIN, listenfd);
+        // Registered once the map is complete, the loops read it while accepting
+        for ( auto& listenLoop : _listenLoops ) {
+            listenLoop.second->AddServer(listenLoop.first, this);
+
+            int32_t errorCode = listenLoop.second->AddEpollEvents(EPOLLIN, listenLoop.first);
+            if (errorCode == -1) {
+                TRACE_ERROR("FATAL epoll_ctl: listen_sock!");
+                assert(0);
+                return errorCode;
+            }
+        }
+
+        return 0;
+    }
 
+    int32_t EPollServer::ListenLocal(int32_t port, int32_t backlog) {
+        int32_t listenfd;
+        if ((listenfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+            TRACE_ERROR("Create local socket failed!");
+            return listenfd;
+        }
+
+        meshy::SetNonBlocking(listenfd);
+
+        struct sockaddr_un addr;
+        socklen_t addrlen = GetLocalAddress(port, &addr);
+        if (bind(listenfd, (struct sockaddr *) &addr, addrlen) < 0 || listen(listenfd, backlog) < 0) {
+            TRACE_WARNING("Listen local socket failed!");
+            close(listenfd);
+            return -1;
+        }
+
+        _localListenfd = listenfd;
+
+        EPollLoop* loop = EPollLoop::Get();
+        loop->AddServer(listenfd, this);
+        int32_t errorCode = loop->AddEpollEvents(EPOLLIN, listenfd);
         if (errorCode == -1) {
-            TRACE_ERROR("FATAL epoll_ctl: listen_sock!");
-            assert(0);
+            TRACE_ERROR("FATAL epoll_ctl: local listen_sock!");
             return errorCode;
         }
 
-        EPollLoop::Get()->AddServer(listenfd, this);
+        return 0;
     }
 
-    EPollConnectionPtr EPollServer::Accept(int32_t sockfd) {
+    EPollConnectionPtr EPollServer::Accept(int32_t listenfd) {
         int32_t conn_sock;
-        int32_t addrlen;
-        int32_t remote;
+        NativeSocketAddress remote;
+        socklen_t addrlen = sizeof(remote);
 
-        int32_t listenfd = GetNativeSocket();
-        while ((conn_sock = accept(listenfd, (struct sockaddr *) &remote,
-                                   (socklen_t * ) & addrlen)) > 0) {
+        EPollLoop* loop = listenfd == _localListenfd ?
+            EPollLoop::Next() : _listenLoops.find(listenfd)->second;
+        while ((conn_sock = accept(listenfd, (struct sockaddr *) &remote, &addrlen)) > 0) {
             meshy::SetNonBlocking(conn_sock);
 
-            NativeSocketEvent ev;
-            ev.events = EPOLLIN | EPOLLET;
-            ev.data.fd = conn_sock;
+            EPollConnectionPtr connection = std::make_shared<EPollConnection>(conn_sock);
+            connection->SetLoop(loop);
 
-            if (epoll_ctl(sockfd, EPOLL_CTL_ADD, conn_sock, &ev) == -1) {
-                perror("epoll_ctl: add");
-                exit(EXIT_FAILURE);
-            }
+            EPollConnection* stream = connection.get();
+            connection->OnCloseIndication([this, stream]() {
+                if ( _disconnectIndication ) {
+                    _disconnectIndication(stream);
+                }
+            });
 
-            EPollConnectionPtr connection = std::make_shared<EPollConnection>(conn_sock);
+            // The loop may be another thread which reads as soon as the socket is added to epoll,
+            // so the handler installs the data indication first
             if ( _connectHandler ) {
                 _connectHandler(connection.get());
             }
 
+            loop->AddStream(connection);
+            if (loop->AddEpollEvents(connection->GetEvents(), conn_sock) == -1) {
+                perror("epoll_ctl: add");
+                exit(EXIT_FAILURE);
+            }
+
             return connection;
         } // while
 
@@ -121,4 +202,4 @@ namespace meshy {
 
         return EPollConnectionPtr(nullptr);
     }
-}
+}
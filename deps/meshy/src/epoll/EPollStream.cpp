@@ -25,6 +25,9 @@
 #include "epoll/EPollLoop.h"
 #include "utils/logger.h"
 #include <unistd.h>
+#include <sys/uio.h>
+#include <cstring>
+#include <algorithm>
 #include "bytearray.h"
 
 namespace meshy {
@@ -33,38 +36,189 @@ namespace meshy {
         int32_t nread = 0;
         NativeSocketEvent ev;
 
-        while ((nread = read(GetNativeSocket(), buffer + readSize, bufferSize - 1)) > 0) {
+        while (readSize < bufferSize &&
+                (nread = read(GetNativeSocket(), buffer + readSize, bufferSize - readSize)) > 0) {
             readSize += nread;
         }
 
         return nread;
     }
 
+    int32_t EPollStream::ReceiveBuffered(int32_t &readSize) {
+        readSize = 0;
+
+        // Bursts larger than the buffer land here first, then the buffer grows to hold them
+        char extraBuffer[MAX_RECV_BUFF];
+        size_t receivedSize = 0;
+        ssize_t nread = 0;
+
+        while (receivedSize < RECV_BUFF_LIMIT) {
+            size_t freeSize = _receiveBuffer.size() - receivedSize;
+
+            struct iovec vectors[2];
+            vectors[0].iov_base = _receiveBuffer.data() + receivedSize;
+            vectors[0].iov_len = freeSize;
+            vectors[1].iov_base = extraBuffer;
+            vectors[1].iov_len = std::min(sizeof(extraBuffer), RECV_BUFF_LIMIT - _receiveBuffer.size());
+
+            nread = readv(GetNativeSocket(), vectors, 2);
+            if (nread < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (nread <= 0) {
+                break;
+            }
+
+            if (size_t(nread) <= freeSize) {
+                receivedSize += nread;
+                continue;
+            }
+
+            size_t extraSize = nread - freeSize;
+            receivedSize = _receiveBuffer.size();
+            _receiveBuffer.resize(std::min(std::max(_receiveBuffer.size() * 2, receivedSize + extraSize),
+                    size_t(RECV_BUFF_LIMIT)));
+            memcpy(_receiveBuffer.data() + receivedSize, extraBuffer, extraSize);
+            receivedSize += extraSize;
+        }
+
+        readSize = int32_t(receivedSize);
+
+        return int32_t(nread);
+    }
+
     int32_t EPollStream::Send(const meshy::ByteArray& byteArray) {
-        TRACE_DEBUG("EPollConnection::Send");
+        return Send(byteArray.data(), int32_t(byteArray.size()));
+    }
+
+    int32_t EPollStream::Send(const char *buf, int32_t size) {
+        TRACE_DEBUG("EPollStream::Send");
+
+        std::unique_lock<std::mutex> locker(_sendMutex);
+
+        // Keep the order of the data, the queue is written first
+        if ( !_sendQueue.empty() ) {
+            _sendQueue.push_back(ByteArray(buf, size));
+            _sendQueueSize += size;
+
+            return 0;
+        }
 
-        struct epoll_event ev;
         NativeSocket clientSocket = GetNativeSocket();
+        int32_t written = 0;
+
+        while (written < size) {
+            int32_t nwrite = write(clientSocket, buf + written, size - written);
+            if (nwrite > 0) {
+                written += nwrite;
+            }
+            else if (nwrite == -1 && errno == EINTR) {
+                continue;
+            }
+            else if (nwrite == -1 && errno == EAGAIN) {
+                break;
+            }
+            else {
+                TRACE_ERROR("FATAL write data to peer failed!");
+                return -1;
+            }
+        }
+
+        if (written == size) {
+            return 0;
+        }
+
+        _sendQueue.push_back(ByteArray(buf + written, size - written));
+        _sendQueueSize += size - written;
 
-        if ( EPollLoop::Get()->ModifyEpollEvents(_events | EPOLLOUT, clientSocket) ) {
-            // TODO: MARK ERASE
+        if ( _loop->ModifyEpollEvents(_events | EPOLLOUT, clientSocket) ) {
             TRACE_ERROR("FATAL epoll_ctl: mod failed!");
         }
 
-        const char *buf = byteArray.data();
-        int32_t size = byteArray.size();
-        int32_t n = size;
+        return 0;
+    }
+
+    void EPollStream::PauseReceiving() {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+        if ( _receivingPaused ) {
+            return;
+        }
+
+        _receivingPaused = true;
+        _events &= ~EPOLLIN;
+        uint32_t events = _sendQueue.empty() ? _events : _events | EPOLLOUT;
+        if ( _loop->ModifyEpollEvents(events, GetNativeSocket()) ) {
+            TRACE_ERROR("FATAL epoll_ctl: mod failed!");
+        }
+    }
+
+    void EPollStream::ResumeReceiving() {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+        if ( !_receivingPaused ) {
+            return;
+        }
+
+        _receivingPaused = false;
+        _events |= EPOLLIN;
+        uint32_t events = _sendQueue.empty() ? _events : _events | EPOLLOUT;
+        if ( _loop->ModifyEpollEvents(events, GetNativeSocket()) ) {
+            TRACE_ERROR("FATAL epoll_ctl: mod failed!");
+        }
+    }
+
+    int32_t EPollStream::Flush() {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+
+        return _FlushSendQueue();
+    }
+
+    int32_t EPollStream::_FlushSendQueue() {
+        NativeSocket clientSocket = GetNativeSocket();
+
+        while ( !_sendQueue.empty() ) {
+            struct iovec iov[MAX_SEND_IOV];
+            int32_t iovCount = 0;
+            for ( auto buffer = _sendQueue.begin();
+                  buffer != _sendQueue.end() && iovCount < MAX_SEND_IOV; ++ buffer ) {
+                size_t offset = iovCount == 0 ? _sendOffset : 0;
+                iov[iovCount].iov_base = const_cast<char*>(buffer->data()) + offset;
+                iov[iovCount].iov_len = buffer->size() - offset;
+                iovCount ++;
+            }
 
-        while (n > 0) {
-            int32_t nwrite;
-            nwrite = write(clientSocket, buf + size - n, n);
-            if (nwrite < n) {
-                if (nwrite == -1 && errno != EAGAIN) {
-                    TRACE_ERROR("FATAL write data to peer failed!");
+            ssize_t nwrite = writev(clientSocket, iov, iovCount);
+            if (nwrite == -1) {
+                if (errno == EINTR) {
+                    continue;
                 }
-                break;
+
+                // Wait for the next EPOLLOUT
+                if (errno == EAGAIN) {
+                    return 0;
+                }
+
+                TRACE_ERROR("FATAL write data to peer failed!");
+                return -1;
+            }
+
+            _sendQueueSize -= nwrite;
+            while (nwrite > 0) {
+                size_t remaining = _sendQueue.front().size() - _sendOffset;
+                if (size_t(nwrite) < remaining) {
+                    _sendOffset += nwrite;
+                    break;
+                }
+
+                nwrite -= remaining;
+                _sendOffset = 0;
+                _sendQueue.pop_front();
             }
-            n -= nwrite;
+        }
+
+        // Nothing is left to write, stop listening for EPOLLOUT
+        if ( _loop->ModifyEpollEvents(_events, clientSocket) ) {
+            TRACE_ERROR("FATAL epoll_ctl: mod failed!");
         }
 
         return 0;
@@ -0,0 +1,174 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "uring/URing.h"
+#include "utils/logger.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+namespace meshy {
+    URing::URing() : _ringfd(-1), _submissionRing(MAP_FAILED), _submissionRingSize(0),
+            _completionRing(MAP_FAILED), _completionRingSize(0), _submissionHead(nullptr),
+            _submissionTail(nullptr), _submissionMask(0), _submissionEntries(0),
+            _submissions(static_cast<struct io_uring_sqe*>(MAP_FAILED)), _submissionsSize(0),
+            _preparedTail(0), _completionHead(nullptr), _completionTail(nullptr),
+            _completionMask(0), _completions(nullptr) {
+    }
+
+    URing::~URing() {
+        if ( _submissions != MAP_FAILED ) {
+            munmap(_submissions, _submissionsSize);
+        }
+
+        if ( _completionRing != MAP_FAILED && _completionRing != _submissionRing ) {
+            munmap(_completionRing, _completionRingSize);
+        }
+
+        if ( _submissionRing != MAP_FAILED ) {
+            munmap(_submissionRing, _submissionRingSize);
+        }
+
+        if ( _ringfd >= 0 ) {
+            close(_ringfd);
+        }
+    }
+
+    int32_t URing::Initialize(uint32_t entries) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        _ringfd = int32_t(syscall(__NR_io_uring_setup, entries, &params));
+        if ( _ringfd < 0 ) {
+            TRACE_ERROR("io_uring_setup failed!");
+            return -1;
+        }
+
+        _submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        _completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+        // Both rings share one mapping on every kernel that supports the features used here
+        if ( params.features & IORING_FEAT_SINGLE_MMAP ) {
+            if ( _completionRingSize > _submissionRingSize ) {
+                _submissionRingSize = _completionRingSize;
+            }
+            _completionRingSize = _submissionRingSize;
+        }
+
+        _submissionRing = mmap(nullptr, _submissionRingSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, _ringfd, IORING_OFF_SQ_RING);
+        if ( _submissionRing == MAP_FAILED ) {
+            TRACE_ERROR("mmap io_uring submission ring failed!");
+            return -1;
+        }
+
+        if ( params.features & IORING_FEAT_SINGLE_MMAP ) {
+            _completionRing = _submissionRing;
+        }
+        else {
+            _completionRing = mmap(nullptr, _completionRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, _ringfd, IORING_OFF_CQ_RING);
+            if ( _completionRing == MAP_FAILED ) {
+                TRACE_ERROR("mmap io_uring completion ring failed!");
+                return -1;
+            }
+        }
+
+        _submissionsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        _submissions = static_cast<struct io_uring_sqe*>(mmap(nullptr, _submissionsSize,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringfd, IORING_OFF_SQES));
+        if ( _submissions == MAP_FAILED ) {
+            TRACE_ERROR("mmap io_uring submission entries failed!");
+            return -1;
+        }
+
+        char* submissionRing = static_cast<char*>(_submissionRing);
+        _submissionHead = reinterpret_cast<uint32_t*>(submissionRing + params.sq_off.head);
+        _submissionTail = reinterpret_cast<uint32_t*>(submissionRing + params.sq_off.tail);
+        _submissionMask = *reinterpret_cast<uint32_t*>(submissionRing + params.sq_off.ring_mask);
+        _submissionEntries = *reinterpret_cast<uint32_t*>(submissionRing + params.sq_off.ring_entries);
+        _preparedTail = *_submissionTail;
+
+        // Entry i of the queue always refers to submission i
+        uint32_t* submissionArray = reinterpret_cast<uint32_t*>(submissionRing + params.sq_off.array);
+        for ( uint32_t index = 0; index < _submissionEntries; index ++ ) {
+            submissionArray[index] = index;
+        }
+
+        char* completionRing = static_cast<char*>(_completionRing);
+        _completionHead = reinterpret_cast<uint32_t*>(completionRing + params.cq_off.head);
+        _completionTail = reinterpret_cast<uint32_t*>(completionRing + params.cq_off.tail);
+        _completionMask = *reinterpret_cast<uint32_t*>(completionRing + params.cq_off.ring_mask);
+        _completions = reinterpret_cast<struct io_uring_cqe*>(completionRing + params.cq_off.cqes);
+
+        return 0;
+    }
+
+    struct io_uring_sqe* URing::GetSubmission() {
+        uint32_t head = __atomic_load_n(_submissionHead, __ATOMIC_ACQUIRE);
+        if ( _preparedTail - head >= _submissionEntries ) {
+            return nullptr;
+        }
+
+        struct io_uring_sqe* submission = &_submissions[_preparedTail & _submissionMask];
+        _preparedTail ++;
+        memset(submission, 0, sizeof(*submission));
+
+        return submission;
+    }
+
+    int32_t URing::Submit(uint32_t waitCount) {
+        __atomic_store_n(_submissionTail, _preparedTail, __ATOMIC_RELEASE);
+        // Entries a refused io_uring_enter left in the ring are passed again with the new ones
+        uint32_t submitCount = _preparedTail - __atomic_load_n(_submissionHead, __ATOMIC_ACQUIRE);
+
+        uint32_t flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int32_t result;
+        do {
+            result = int32_t(syscall(__NR_io_uring_enter, _ringfd, submitCount, waitCount, flags, nullptr, 0));
+        } while ( result < 0 && errno == EINTR && waitCount == 0 );
+
+        return result;
+    }
+
+    struct io_uring_cqe* URing::PeekCompletion() {
+        uint32_t head = *_completionHead;
+        if ( head == __atomic_load_n(_completionTail, __ATOMIC_ACQUIRE) ) {
+            return nullptr;
+        }
+
+        return &_completions[head & _completionMask];
+    }
+
+    void URing::SeenCompletion() {
+        __atomic_store_n(_completionHead, *_completionHead + 1, __ATOMIC_RELEASE);
+    }
+
+    int32_t URing::RegisterBufferRing(struct io_uring_buf_ring* bufferRing, uint32_t entries, uint16_t groupId) {
+        struct io_uring_buf_reg registration;
+        memset(&registration, 0, sizeof(registration));
+        registration.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+        registration.ring_entries = entries;
+        registration.bgid = groupId;
+
+        return int32_t(syscall(__NR_io_uring_register, _ringfd, IORING_REGISTER_PBUF_RING, &registration, 1));
+    }
+}
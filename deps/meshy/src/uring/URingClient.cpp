@@ -0,0 +1,79 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "uring/URingClient.h"
+#include "uring/URingLoop.h"
+#include "utils/common_utils.h"
+#include "utils/logger.h"
+
+#include <unistd.h>
+#include <strings.h>
+#include <arpa/inet.h>
+
+namespace meshy {
+    void URingClient::Connect(const std::string& host, int port) {
+        struct sockaddr_in serv_addr;
+
+        bzero((char *) &serv_addr, sizeof(serv_addr));
+        serv_addr.sin_family = AF_INET;
+        serv_addr.sin_addr.s_addr = inet_addr(host.c_str());
+        serv_addr.sin_port = htons(port);
+
+        if ( connect(GetNativeSocket(), (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0 ) {
+            TRACE_ERROR("Connect to peer failed!");
+        }
+    }
+
+    URingClientPtr URingClient::Connect(const std::string &ip, int32_t port, DataSink* dataSink) {
+        int32_t clientSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+
+        // Connect
+        URingClientPtr client = URingClientPtr(new URingClient(clientSocket));
+        client->SetDataSink(dataSink);
+        client->Connect(ip, port);
+
+        return _Attach(client);
+    }
+
+    URingClientPtr URingClient::ConnectLocal(int32_t port, DataSink* dataSink) {
+        int32_t clientSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if ( clientSocket < 0 ) {
+            return URingClientPtr(nullptr);
+        }
+
+        struct sockaddr_un serv_addr;
+        socklen_t addrlen = GetLocalAddress(port, &serv_addr);
+        if ( connect(clientSocket, (struct sockaddr *) &serv_addr, addrlen) < 0 ) {
+            close(clientSocket);
+            return URingClientPtr(nullptr);
+        }
+
+        URingClientPtr client = URingClientPtr(new URingClient(clientSocket));
+        client->SetDataSink(dataSink);
+
+        return _Attach(client);
+    }
+
+    URingClientPtr URingClient::_Attach(URingClientPtr client) {
+        URingLoop *uringLoop = URingLoop::Next();
+        client->SetLoop(uringLoop);
+        uringLoop->AddStream(client);
+
+        return client;
+    }
+}
@@ -0,0 +1,534 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "uring/URingLoop.h"
+#include "utils/logger.h"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace meshy {
+    // Buffer group the receive buffers of every ring are registered as
+    const uint16_t RECEIVE_BUFFER_GROUP = 0;
+
+    int32_t URingLoop::_loopCount = 0;
+    URingLoop::ThreadStartHandler URingLoop::_threadStartHandler;
+
+    URingLoop* URingLoop::Get()
+    {
+        return _GetLoops()[0];
+    }
+
+    URingLoop* URingLoop::Get(int32_t index)
+    {
+        return _GetLoops()[index];
+    }
+
+    URingLoop* URingLoop::Next()
+    {
+        static std::atomic<uint32_t> nextLoop(0);
+        std::vector<URingLoop*>& loops = _GetLoops();
+
+        return loops[nextLoop ++ % loops.size()];
+    }
+
+    int32_t URingLoop::GetLoopCount()
+    {
+        return int32_t(_GetLoops().size());
+    }
+
+    void URingLoop::SetLoopCount(int32_t loopCount)
+    {
+        _loopCount = loopCount;
+    }
+
+    void URingLoop::SetThreadStartHandler(ThreadStartHandler handler)
+    {
+        _threadStartHandler = handler;
+    }
+
+    std::vector<URingLoop*>& URingLoop::_GetLoops()
+    {
+        static std::vector<URingLoop*> loops = [] {
+            int32_t loopCount = _loopCount;
+            if ( loopCount <= 0 ) {
+                loopCount = std::max(int32_t(std::thread::hardware_concurrency()), 1);
+            }
+
+            std::vector<URingLoop*> createdLoops;
+            for ( int32_t loopIndex = 0; loopIndex < loopCount; loopIndex ++ ) {
+                createdLoops.push_back(new URingLoop);
+            }
+
+            return createdLoops;
+        }();
+
+        return loops;
+    }
+
+    URingLoop::URingLoop() : _shutdown(false), _started(false), _wakeupfd(-1), _wakeupValue(0),
+            _wakeupPending(false), _bufferRing(nullptr), _buffers(nullptr), _bufferTail(0)
+    {
+        TRACE_DEBUG("URingLoop::URingLoop");
+
+        // Sends pass MSG_NOSIGNAL, a peer which went away does not raise SIGPIPE
+        _Initialize();
+    }
+
+    URingLoop::~URingLoop()
+    {
+        _shutdown = true;
+    }
+
+    void URingLoop::_Initialize()
+    {
+        if ( _ring.Initialize(URING_ENTRIES) == -1 ) {
+            TRACE_ERROR("FATAL io_uring setup failed!");
+            assert(0);
+            exit(EXIT_FAILURE);
+        }
+
+        _wakeupfd = eventfd(0, EFD_CLOEXEC);
+        if ( _wakeupfd == -1 ) {
+            TRACE_ERROR("FATAL eventfd failed!");
+            assert(0);
+        }
+
+        size_t bufferRingSize = URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+        void* bufferRing = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE,
+                MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if ( bufferRing == MAP_FAILED ) {
+            TRACE_ERROR("FATAL mmap buffer ring failed!");
+            assert(0);
+            exit(EXIT_FAILURE);
+        }
+
+        _bufferRing = static_cast<struct io_uring_buf_ring*>(bufferRing);
+        _buffers = new char[URING_BUFFER_COUNT * URING_BUFFER_SIZE];
+
+        if ( _ring.RegisterBufferRing(_bufferRing, URING_BUFFER_COUNT, RECEIVE_BUFFER_GROUP) < 0 ) {
+            TRACE_ERROR("FATAL io_uring buffer ring registration failed!");
+            assert(0);
+            exit(EXIT_FAILURE);
+        }
+
+        for ( uint16_t bufferId = 0; bufferId < URING_BUFFER_COUNT; bufferId ++ ) {
+            _RecycleBuffer(bufferId);
+        }
+    }
+
+    void URingLoop::AddServer(NativeSocket socket, URingServer* server)
+    {
+        {
+            std::lock_guard<std::mutex> locker(_pendingMutex);
+            _pendingServers.push_back({socket, server});
+        }
+
+        _Wakeup();
+    }
+
+    void URingLoop::AddStream(URingStreamPtr stream)
+    {
+        {
+            std::lock_guard<std::mutex> locker(_pendingMutex);
+            _pendingStreams.push_back(stream);
+        }
+
+        _Wakeup();
+    }
+
+    void URingLoop::ScheduleSend(NativeSocket fd)
+    {
+        {
+            std::lock_guard<std::mutex> locker(_pendingMutex);
+            _pendingSends.push_back(fd);
+        }
+
+        _Wakeup();
+    }
+
+    void URingLoop::ScheduleReceive(NativeSocket fd)
+    {
+        {
+            std::lock_guard<std::mutex> locker(_pendingMutex);
+            _pendingReceives.push_back(fd);
+        }
+
+        _Wakeup();
+    }
+
+    void URingLoop::_Wakeup()
+    {
+        // One write is enough until the loop has picked the pending work up
+        if ( !_wakeupPending.exchange(true) ) {
+            eventfd_write(_wakeupfd, 1);
+        }
+    }
+
+    void URingLoop::_AddPending()
+    {
+        std::vector<std::pair<NativeSocket, URingServer*>> pendingServers;
+        std::vector<URingStreamPtr> pendingStreams;
+        std::vector<NativeSocket> pendingSends;
+        std::vector<NativeSocket> pendingReceives;
+
+        {
+            std::lock_guard<std::mutex> locker(_pendingMutex);
+            _wakeupPending = false;
+
+            pendingServers.swap(_pendingServers);
+            pendingStreams.swap(_pendingStreams);
+            pendingSends.swap(_pendingSends);
+            pendingReceives.swap(_pendingReceives);
+        }
+
+        for ( auto& pendingServer : pendingServers ) {
+            if ( pendingServer.first >= NativeSocket(_servers.size()) ) {
+                _servers.resize(pendingServer.first + 1);
+            }
+
+            _servers[pendingServer.first] = pendingServer.second;
+            _SubmitAccept(pendingServer.first);
+        }
+
+        for ( URingStreamPtr& pendingStream : pendingStreams ) {
+            NativeSocket fd = pendingStream->GetNativeSocket();
+            if ( fd >= NativeSocket(_streams.size()) ) {
+                _streams.resize(fd + 1);
+            }
+
+            _streams[fd] = std::move(pendingStream);
+            _SubmitReceive(_streams[fd].get());
+        }
+
+        for ( NativeSocket fd : pendingSends ) {
+            if ( fd < NativeSocket(_streams.size()) && _streams[fd] && !_streams[fd]->_sending ) {
+                _SubmitSend(_streams[fd].get());
+            }
+        }
+
+        for ( NativeSocket fd : pendingReceives ) {
+            if ( fd < NativeSocket(_streams.size()) && _streams[fd] ) {
+                _UpdateReceive(_streams[fd].get());
+            }
+        }
+    }
+
+    void URingLoop::_Run()
+    {
+        // Callers only know the default loop
+        if ( this == Get() ) {
+            for ( URingLoop* loop : _GetLoops() ) {
+                loop->_StartThread();
+            }
+        }
+        else {
+            _StartThread();
+        }
+    }
+
+    void URingLoop::_StartThread()
+    {
+        bool started = false;
+        if ( !_started.compare_exchange_strong(started, true) ) {
+            return;
+        }
+
+        auto func = std::bind(&URingLoop::_URingThread, this);
+        std::thread listenThread(func);
+        listenThread.detach();
+    }
+
+    void URingLoop::_URingThread()
+    {
+        TRACE_DEBUG("_URingThread");
+
+        if ( _threadStartHandler ) {
+            std::vector<URingLoop*>& loops = _GetLoops();
+            _threadStartHandler(int32_t(std::find(loops.begin(), loops.end(), this) - loops.begin()));
+        }
+
+        _SubmitWakeup();
+
+        while (!_shutdown) {
+            _AddPending();
+
+            // Everything prepared since the last pass goes to the kernel in one call
+            if (_ring.Submit(_deferredCompletions.empty() ? 1 : 0) < 0 && errno != EINTR && errno != EBUSY) {
+                TRACE_ERROR("FATAL io_uring_enter failed!");
+                exit(EXIT_FAILURE);
+            }
+
+            std::vector<Completion> deferredCompletions;
+            deferredCompletions.swap(_deferredCompletions);
+            for (const Completion& deferredCompletion : deferredCompletions) {
+                _HandleCompletion(deferredCompletion.userData, deferredCompletion.result, deferredCompletion.flags);
+            }
+
+            struct io_uring_cqe* completion;
+            while ((completion = _ring.PeekCompletion()) != nullptr) {
+                uint64_t userData = completion->user_data;
+                int32_t result = completion->res;
+                uint32_t flags = completion->flags;
+                _ring.SeenCompletion();
+
+                _HandleCompletion(userData, result, flags);
+            }
+        }
+    }
+
+    struct io_uring_sqe* URingLoop::_GetSubmission(Operation::Values operation, NativeSocket fd)
+    {
+        struct io_uring_sqe* submission = _ring.GetSubmission();
+        while ( !submission ) {
+            // The kernel refuses entries with EBUSY while its completion queue is full. The completions
+            // are moved aside to make room, the loop handles them once the current one returns.
+            if ( _ring.Submit(0) < 0 && errno != EINTR && errno != EBUSY ) {
+                TRACE_ERROR("FATAL io_uring_enter failed!");
+                exit(EXIT_FAILURE);
+            }
+
+            struct io_uring_cqe* completion;
+            while ( (completion = _ring.PeekCompletion()) != nullptr ) {
+                _deferredCompletions.push_back({ completion->user_data, completion->res, completion->flags });
+                _ring.SeenCompletion();
+            }
+
+            submission = _ring.GetSubmission();
+        }
+
+        submission->fd = fd;
+        submission->user_data = (uint64_t(operation) << 32) | uint32_t(fd);
+
+        return submission;
+    }
+
+    void URingLoop::_SubmitAccept(NativeSocket listenfd)
+    {
+        struct io_uring_sqe* submission = _GetSubmission(Operation::Accept, listenfd);
+        submission->opcode = IORING_OP_ACCEPT;
+        submission->ioprio = IORING_ACCEPT_MULTISHOT;
+        submission->accept_flags = SOCK_CLOEXEC;
+    }
+
+    void URingLoop::_SubmitReceive(URingStream* stream)
+    {
+        struct io_uring_sqe* submission = _GetSubmission(Operation::Receive, stream->GetNativeSocket());
+        submission->opcode = IORING_OP_RECV;
+        submission->ioprio = IORING_RECV_MULTISHOT;
+        submission->flags = IOSQE_BUFFER_SELECT;
+        submission->buf_group = RECEIVE_BUFFER_GROUP;
+
+        stream->_receiving = true;
+    }
+
+    void URingLoop::_SubmitSend(URingStream* stream)
+    {
+        struct io_uring_sqe* submission = _GetSubmission(Operation::Send, stream->GetNativeSocket());
+        submission->opcode = IORING_OP_SENDMSG;
+        submission->addr = reinterpret_cast<uint64_t>(stream->_PrepareSend());
+        submission->len = 1;
+        submission->msg_flags = MSG_NOSIGNAL;
+
+        stream->_sending = true;
+    }
+
+    void URingLoop::_SubmitWakeup()
+    {
+        struct io_uring_sqe* submission = _GetSubmission(Operation::Wakeup, _wakeupfd);
+        submission->opcode = IORING_OP_READ;
+        submission->addr = reinterpret_cast<uint64_t>(&_wakeupValue);
+        submission->len = sizeof(_wakeupValue);
+    }
+
+    void URingLoop::_SubmitCancel(URingStream* stream)
+    {
+        NativeSocket fd = stream->GetNativeSocket();
+        struct io_uring_sqe* submission = _GetSubmission(Operation::Cancel, fd);
+        submission->opcode = IORING_OP_ASYNC_CANCEL;
+        submission->addr = (uint64_t(Operation::Receive) << 32) | uint32_t(fd);
+    }
+
+    void URingLoop::_UpdateReceive(URingStream* stream)
+    {
+        if ( stream->_closed ) {
+            return;
+        }
+
+        // The receive ends with -ECANCELED, _Read leaves it unarmed while the stream is paused
+        if ( stream->_receivingPaused && stream->_receiving ) {
+            _SubmitCancel(stream);
+        }
+        else if ( !stream->_receivingPaused && !stream->_receiving ) {
+            _SubmitReceive(stream);
+        }
+    }
+
+    void URingLoop::_HandleCompletion(uint64_t userData, int32_t result, uint32_t flags)
+    {
+        Operation::Values operation = Operation::Values(userData >> 32);
+        NativeSocket fd = NativeSocket(userData & 0xffffffff);
+
+        switch ( operation ) {
+        case Operation::Accept:
+            _Accept(fd, result, flags);
+            break;
+        case Operation::Receive:
+            _Read(fd, result, flags);
+            break;
+        case Operation::Send:
+            _Write(fd, result);
+            break;
+        case Operation::Wakeup:
+            _SubmitWakeup();
+            break;
+        case Operation::Cancel:
+            break;
+        }
+    }
+
+    void URingLoop::_Accept(NativeSocket listenfd, int32_t result, uint32_t flags)
+    {
+        TRACE_DEBUG("_Accept");
+
+        URingServer* server = _servers[listenfd];
+        if ( result >= 0 ) {
+            server->Attach(listenfd, result);
+        }
+        else if ( result != -EAGAIN && result != -ECONNABORTED && result != -EPROTO && result != -EINTR ) {
+            TRACE_WARNING("io_uring accept failed!");
+        }
+
+        // The kernel ends a multishot request on errors or overflow, it has to be armed again
+        if ( !(flags & IORING_CQE_F_MORE) ) {
+            _SubmitAccept(listenfd);
+        }
+    }
+
+    void URingLoop::_Read(NativeSocket fd, int32_t result, uint32_t flags)
+    {
+        TRACE_DEBUG("_Read");
+
+        URingStream* stream = _streams[fd].get();
+
+        if ( result > 0 && (flags & IORING_CQE_F_BUFFER) ) {
+            uint16_t bufferId = uint16_t(flags >> IORING_CQE_BUFFER_SHIFT);
+
+            // The handler reads straight from the provided buffer, it is reused afterwards
+            if ( stream->GetDataIndication() ) {
+                stream->GetDataIndication()(_buffers + size_t(bufferId) * URING_BUFFER_SIZE, result);
+            }
+
+            _RecycleBuffer(bufferId);
+        }
+
+        if ( flags & IORING_CQE_F_MORE ) {
+            return;
+        }
+
+        stream->_receiving = false;
+
+        // Out of buffers or the request just ended, the buffers recycled by now are enough to go on.
+        // A paused stream is armed again when it resumes.
+        if ( (result > 0 || result == -ENOBUFS || result == -ECANCELED) && !stream->_closed ) {
+            if ( !stream->_receivingPaused ) {
+                _SubmitReceive(stream);
+            }
+            return;
+        }
+
+        if ( result < 0 && result != -ENOBUFS && result != -ECONNRESET ) {
+            char message[50];
+            sprintf(message, "errno: %d: %s", -result, strerror(-result));
+            TRACE_WARNING(message);
+        }
+
+        _Close(stream);
+    }
+
+    void URingLoop::_Write(NativeSocket fd, int32_t result)
+    {
+        TRACE_DEBUG("_Write");
+
+        URingStream* stream = _streams[fd].get();
+        stream->_sending = false;
+
+        if ( result == -EINTR || result == -EAGAIN ) {
+            _SubmitSend(stream);
+            return;
+        }
+
+        if ( result < 0 ) {
+            TRACE_ERROR("FATAL write data to peer failed!");
+            _Close(stream);
+            return;
+        }
+
+        if ( stream->_CompleteSend(size_t(result)) ) {
+            _SubmitSend(stream);
+            return;
+        }
+
+        if ( stream->_closed ) {
+            _Close(stream);
+        }
+    }
+
+    void URingLoop::_Close(URingStream* stream)
+    {
+        stream->_Close();
+
+        // Ends the receive request, its completion closes the stream again
+        if ( stream->_receiving ) {
+            shutdown(stream->GetNativeSocket(), SHUT_RDWR);
+            return;
+        }
+
+        if ( stream->_sending ) {
+            return;
+        }
+
+        NativeSocket fd = stream->GetNativeSocket();
+        URingStreamPtr closedStream = std::move(_streams[fd]);
+
+        // As with epoll the owner of a client stream may still hold it, the fd is closed
+        // with the last reference and only shut down here
+        shutdown(fd, SHUT_RDWR);
+
+        if ( closedStream->GetCloseIndication() ) {
+            closedStream->GetCloseIndication()();
+        }
+    }
+
+    void URingLoop::_RecycleBuffer(uint16_t bufferId)
+    {
+        // Not bufs[], the flexible array of the kernel header starts 8 bytes late when compiled as C++
+        struct io_uring_buf* buffer = reinterpret_cast<struct io_uring_buf*>(_bufferRing) +
+                (_bufferTail & (URING_BUFFER_COUNT - 1));
+        buffer->addr = reinterpret_cast<uint64_t>(_buffers + size_t(bufferId) * URING_BUFFER_SIZE);
+        buffer->len = URING_BUFFER_SIZE;
+        buffer->bid = bufferId;
+
+        _bufferTail ++;
+        __atomic_store_n(&_bufferRing->tail, _bufferTail, __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,177 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "uring/URingServer.h"
+#include "uring/URingLoop.h"
+#include "utils/common_utils.h"
+#include "utils/logger.h"
+
+#include <unistd.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include <cstdlib>
+
+namespace meshy {
+    URingServer::~URingServer() {
+        for ( auto& listenLoop : _listenLoops ) {
+            if ( listenLoop.first != GetNativeSocket() ) {
+                close(listenLoop.first);
+            }
+        }
+
+        if ( _localListenfd >= 0 ) {
+            close(_localListenfd);
+        }
+    }
+
+    int32_t URingServer::_Bind(const std::string& host, int32_t port, bool reusePort) {
+        int32_t listenfd;
+        if ((listenfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+            TRACE_ERROR("Create socket failed!");
+            exit(1);
+        }
+
+        int32_t option = 1;
+        setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+        // Lets every loop listen on the same address, the kernel spreads the connections
+        if (reusePort && setsockopt(listenfd, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) < 0) {
+            TRACE_WARNING("SO_REUSEPORT is not supported!");
+            close(listenfd);
+            return -1;
+        }
+
+        NativeSocketAddress addr;
+        bzero(&addr, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = inet_addr(host.c_str());
+
+        int32_t errorCode = bind(listenfd, (struct sockaddr *) &addr, sizeof(addr));
+        if (errorCode < 0) {
+            TRACE_ERROR("Bind socket failed!");
+            assert(0);
+            close(listenfd);
+            return errorCode;
+        }
+
+        return listenfd;
+    }
+
+    int32_t URingServer::Listen(const std::string& host, int32_t port, int32_t backlog) {
+        int32_t loopCount = URingLoop::GetLoopCount();
+
+        for (int32_t loopIndex = 0; loopIndex < loopCount; ++ loopIndex) {
+            int32_t listenfd = _Bind(host, port, loopCount > 1);
+            if (listenfd < 0) {
+                // Without SO_REUSEPORT the first socket serves every connection
+                if (loopIndex > 0) {
+                    break;
+                }
+
+                listenfd = _Bind(host, port, false);
+                if (listenfd < 0) {
+                    return listenfd;
+                }
+                loopCount = 1;
+            }
+
+            if (loopIndex == 0) {
+                SetNativeSocket(listenfd);
+            }
+
+            int32_t errorCode = listen(listenfd, backlog);
+            if (-1 == errorCode) {
+                TRACE_ERROR("Listen socket failed!");
+                assert(0);
+                return errorCode;
+            }
+
+            _listenLoops[listenfd] = URingLoop::Get(loopIndex);
+        }
+
+        // Registered once the map is complete, the loops read it while accepting
+        for ( auto& listenLoop : _listenLoops ) {
+            listenLoop.second->AddServer(listenLoop.first, this);
+        }
+
+        return 0;
+    }
+
+    int32_t URingServer::ListenLocal(int32_t port, int32_t backlog) {
+        int32_t listenfd;
+        if ((listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+            TRACE_ERROR("Create local socket failed!");
+            return listenfd;
+        }
+
+        struct sockaddr_un addr;
+        socklen_t addrlen = GetLocalAddress(port, &addr);
+        if (bind(listenfd, (struct sockaddr *) &addr, addrlen) < 0 || listen(listenfd, backlog) < 0) {
+            TRACE_WARNING("Listen local socket failed!");
+            close(listenfd);
+            return -1;
+        }
+
+        _localListenfd = listenfd;
+        URingLoop::Get()->AddServer(listenfd, this);
+
+        return 0;
+    }
+
+    URingConnectionPtr URingServer::Accept(int32_t listenfd) {
+        NativeSocketAddress remote;
+        socklen_t addrlen = sizeof(remote);
+
+        int32_t connectionSocket = accept4(listenfd, (struct sockaddr *) &remote, &addrlen, SOCK_CLOEXEC);
+        if (connectionSocket < 0) {
+            if (errno != EAGAIN && errno != ECONNABORTED
+                && errno != EPROTO && errno != EINTR)
+                perror("accept");
+
+            return URingConnectionPtr(nullptr);
+        }
+
+        return Attach(listenfd, connectionSocket);
+    }
+
+    URingConnectionPtr URingServer::Attach(int32_t listenfd, NativeSocket connectionSocket) {
+        URingLoop* loop = listenfd == _localListenfd ?
+            URingLoop::Next() : _listenLoops.find(listenfd)->second;
+
+        URingConnectionPtr connection = std::make_shared<URingConnection>(connectionSocket);
+        connection->SetLoop(loop);
+
+        URingConnection* stream = connection.get();
+        connection->OnCloseIndication([this, stream]() {
+            if ( _disconnectIndication ) {
+                _disconnectIndication(stream);
+            }
+        });
+
+        // The handler installs the data indication before the loop starts receiving
+        if ( _connectHandler ) {
+            _connectHandler(connection.get());
+        }
+
+        loop->AddStream(connection);
+
+        return connection;
+    }
+}
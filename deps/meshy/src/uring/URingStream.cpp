@@ -0,0 +1,133 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "uring/URingStream.h"
+
+#include "uring/URingLoop.h"
+#include "utils/logger.h"
+#include <unistd.h>
+#include <cstring>
+#include "bytearray.h"
+
+namespace meshy {
+    int32_t URingStream::Receive(char *buffer, int32_t bufferSize, int32_t &readSize) {
+        readSize = 0;
+
+        int32_t nread = read(GetNativeSocket(), buffer, bufferSize);
+        if (nread > 0) {
+            readSize = nread;
+        }
+
+        return nread;
+    }
+
+    int32_t URingStream::Send(const meshy::ByteArray& byteArray) {
+        return Send(byteArray.data(), int32_t(byteArray.size()));
+    }
+
+    int32_t URingStream::Send(const char *buffer, int32_t size) {
+        TRACE_DEBUG("URingStream::Send");
+
+        std::unique_lock<std::mutex> locker(_sendMutex);
+        if ( _closed ) {
+            return -1;
+        }
+
+        // The submission writes from the queue, so this is the only copy of the data
+        _sendQueue.push_back(ByteArray(buffer, size));
+        _sendQueueSize += size;
+
+        // The loop keeps sending until the queue is empty, it only has to be told once
+        if ( _sendScheduled ) {
+            return 0;
+        }
+
+        _sendScheduled = true;
+        locker.unlock();
+
+        _loop->ScheduleSend(GetNativeSocket());
+
+        return 0;
+    }
+
+    void URingStream::PauseReceiving() {
+        if ( !_receivingPaused.exchange(true) ) {
+            _loop->ScheduleReceive(GetNativeSocket());
+        }
+    }
+
+    void URingStream::ResumeReceiving() {
+        if ( _receivingPaused.exchange(false) ) {
+            _loop->ScheduleReceive(GetNativeSocket());
+        }
+    }
+
+    struct msghdr* URingStream::_PrepareSend() {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+
+        int32_t iovCount = 0;
+        for ( auto buffer = _sendQueue.begin();
+              buffer != _sendQueue.end() && iovCount < MAX_SEND_IOV; ++ buffer ) {
+            size_t offset = iovCount == 0 ? _sendOffset : 0;
+            _sendVectors[iovCount].iov_base = const_cast<char*>(buffer->data()) + offset;
+            _sendVectors[iovCount].iov_len = buffer->size() - offset;
+            iovCount ++;
+        }
+
+        memset(&_sendMessage, 0, sizeof(_sendMessage));
+        _sendMessage.msg_iov = _sendVectors;
+        _sendMessage.msg_iovlen = iovCount;
+
+        return &_sendMessage;
+    }
+
+    bool URingStream::_CompleteSend(size_t written) {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+
+        _sendQueueSize -= written;
+        while (written > 0) {
+            size_t remaining = _sendQueue.front().size() - _sendOffset;
+            if (written < remaining) {
+                _sendOffset += written;
+                break;
+            }
+
+            written -= remaining;
+            _sendOffset = 0;
+            _sendQueue.pop_front();
+        }
+
+        if ( _sendQueue.empty() || _closed ) {
+            _sendScheduled = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    void URingStream::_Close() {
+        std::unique_lock<std::mutex> locker(_sendMutex);
+
+        _closed = true;
+        if ( !_sending ) {
+            _sendQueue.clear();
+            _sendQueueSize = 0;
+            _sendOffset = 0;
+        }
+    }
+}
@@ -21,8 +21,17 @@
 //
 
 #include <cstdio>
+#include <cstring>
+#include <cstddef>
 #include "utils/common_utils.h"
 
+#ifdef OS_LINUX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <ifaddrs.h>
+#endif
+
 namespace meshy {
 #ifdef OS_LINUX
     int32_t SetNonBlocking(int32_t sockfd)
@@ -42,5 +51,57 @@ namespace meshy {
 
         return 0;
     }
+
+    int32_t SetNoDelay(int32_t sockfd, bool noDelay)
+    {
+        int32_t option = noDelay ? 1 : 0;
+
+        return setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+    }
+
+    bool IsLocalHost(const std::string& host)
+    {
+        if ( host == "localhost" ) {
+            return true;
+        }
+
+        struct in_addr address;
+        if ( inet_pton(AF_INET, host.c_str(), &address) != 1 ) {
+            return false;
+        }
+
+        if ( (ntohl(address.s_addr) >> 24) == 127 ) {
+            return true;
+        }
+
+        struct ifaddrs* interfaces;
+        if ( getifaddrs(&interfaces) < 0 ) {
+            return false;
+        }
+
+        bool local = false;
+        for ( struct ifaddrs* interface = interfaces; interface; interface = interface->ifa_next ) {
+            if ( interface->ifa_addr && interface->ifa_addr->sa_family == AF_INET &&
+                reinterpret_cast<struct sockaddr_in*>(interface->ifa_addr)->sin_addr.s_addr == address.s_addr ) {
+                local = true;
+                break;
+            }
+        }
+        freeifaddrs(interfaces);
+
+        return local;
+    }
+
+    socklen_t GetLocalAddress(int32_t port, struct sockaddr_un* address)
+    {
+        memset(address, 0, sizeof(*address));
+        address->sun_family = AF_UNIX;
+
+        // The name starts with a null byte, so it lives in the abstract namespace
+        // and disappears with the socket instead of leaving a file behind
+        int32_t nameLength = snprintf(address->sun_path + 1, sizeof(address->sun_path) - 1, "meshy-%d", port);
+
+        return socklen_t(offsetof(struct sockaddr_un, sun_path) + 1 + nameLength);
+    }
 #endif
 }
@@ -21,6 +21,7 @@
 #include <cstring>
 #include <vector>
 #include <cstdint>
+#include <string>
 
 namespace hurricane {
 	namespace base {
@@ -71,23 +72,68 @@ namespace hurricane {
 			~IODevice() {}
 		};
 
+		class ByteArrayView {
+		public:
+			ByteArrayView() : _data(nullptr), _size(0) {}
+
+			ByteArrayView(const char* data, int32_t size) :
+				_data(data), _size(size) {
+			}
+
+			ByteArrayView(const ByteArray& buffer) :
+				_data(buffer.data()), _size(buffer.size()) {
+			}
+
+			const char* data() const {
+				return _data;
+			}
+
+			int32_t size() const {
+				return _size;
+			}
+
+			bool empty() const {
+				return _size == 0;
+			}
+
+			std::string ToStdString() const {
+				return std::string(_data, _size);
+			}
+
+			ByteArray ToByteArray() const {
+				return ByteArray(_data, _size);
+			}
+
+		private:
+			const char* _data;
+			int32_t _size;
+		};
+
+		// The reader never owns the bytes it reads, the caller must keep the buffer alive
+		// for as long as the reader and any view returned by ReadView are in use.
 		class ByteArrayReader : public IODevice {
 		public:
+			ByteArrayReader(const char* buffer, int32_t size) :
+				_buffer(buffer), _size(size), _pos(0) {}
+
 			ByteArrayReader(const ByteArray& buffer) :
-				_buffer(buffer), _pos(0) {}
+				ByteArrayReader(buffer.data(), buffer.size()) {}
+
+			ByteArrayReader(const ByteArrayView& buffer) :
+				ByteArrayReader(buffer.data(), buffer.size()) {}
 
 			template <class T>
             int32_t Read(T* buffer, int32_t count) {
-				if ( _pos >= _buffer.size() ) {
+				if ( _pos >= _size ) {
 					return 0;
 				}
 
 				int32_t sizeToRead = sizeof(T) * count;
-				if ( _pos + sizeToRead > _buffer.size() ) {
-					sizeToRead = _buffer.size() - _pos;
+				if ( _pos + sizeToRead > _size ) {
+					sizeToRead = _size - _pos;
 				}
 
-				memcpy(buffer, _pos + _buffer.data(), sizeToRead);
+				memcpy(buffer, _buffer + _pos, sizeToRead);
 				_pos += sizeToRead;
 
 				return sizeToRead;
@@ -95,33 +141,61 @@ namespace hurricane {
 
 			template <class T>
             T Read() {
-				T t;
-                int32_t size = Read(&t, 1);
+				T t = T();
+                Read(&t, 1);
 
 				return t;
 			}
 
-            ByteArray ReadData(int32_t size) {
-				if ( _pos >= _buffer.size() ) {
-					return 0;
+            // LEB128: seven bits per byte, least significant group first, high bit set on all but the last byte
+            uint64_t ReadVarint() {
+				uint64_t value = 0;
+				for ( int32_t shift = 0; shift < 64 && _pos < _size; shift += 7 ) {
+					uint8_t byte = static_cast<uint8_t>(_buffer[_pos ++]);
+					value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+					if ( !(byte & 0x80) ) {
+						break;
+					}
+				}
+
+				return value;
+			}
+
+            int64_t ReadSignedVarint() {
+				uint64_t value = ReadVarint();
+
+				return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+			}
+
+            ByteArrayView ReadView(int32_t size) {
+				if ( _pos >= _size || size <= 0 ) {
+					return ByteArrayView();
 				}
 
 				int32_t sizeToRead = size;
-				if ( _pos + sizeToRead > _buffer.size() ) {
-					sizeToRead = _buffer.size() - _pos;
+				if ( _pos + sizeToRead > _size ) {
+					sizeToRead = _size - _pos;
 				}
 
-				ByteArray result(sizeToRead);
-				memcpy(result.data(), _buffer.data() + _pos, sizeToRead);
+				ByteArrayView result(_buffer + _pos, sizeToRead);
 				_pos += sizeToRead;
 
 				return result;
 			}
 
+            ByteArray ReadData(int32_t size) {
+				return ReadView(size).ToByteArray();
+			}
+
             int32_t Tell() const {
 				return _pos;
 			}
 
+            int32_t GetSize() const {
+				return _size;
+			}
+
             void Seek(SeekMode mode, int32_t size) {
 				int32_t dest = _pos;
 				if ( mode == SeekMode::Set ) {
@@ -133,22 +207,40 @@ namespace hurricane {
 				else if ( mode == SeekMode::Backward ) {
 					dest -= size;
 				}
+
+				if ( dest < 0 ) {
+					dest = 0;
+				}
+				else if ( dest > _size ) {
+					dest = _size;
+				}
+
+				_pos = dest;
 			}
 		private:
-			ByteArray _buffer;
+			const char* _buffer;
+			int32_t _size;
 			int32_t _pos;
 		};
 
+		// Appends directly to its target buffer. The writer either owns the buffer or appends
+		// to a caller supplied one, which lets hot paths reuse the same allocation for every frame.
 		class ByteArrayWriter {
 		public:
-			ByteArrayWriter() {
+			ByteArrayWriter() : _buffer(&_ownedBuffer) {
+			}
+
+			ByteArrayWriter(ByteArray& buffer) : _buffer(&buffer) {
 			}
 
+			ByteArrayWriter(const ByteArrayWriter&) = delete;
+			const ByteArrayWriter& operator=(const ByteArrayWriter&) = delete;
+
 			template <class T>
             int32_t Write(const T* buffer, int32_t count) {
 				int32_t sizeToWrite = sizeof(T) * count;
-				ByteArray buffer2((const char*)(buffer), sizeToWrite);
-                _buffer.Concat(buffer2);
+				const char* bytes = reinterpret_cast<const char*>(buffer);
+				_buffer->insert(_buffer->end(), bytes, bytes + sizeToWrite);
 
 				return sizeToWrite;
 			}
@@ -159,22 +251,64 @@ namespace hurricane {
 			}
 
             int32_t Write(const ByteArray& buffer) {
-                _buffer.Concat(buffer);
+                _buffer->insert(_buffer->end(), buffer.cbegin(), buffer.cend());
 
 				return buffer.size();
 			}
 
-			const ByteArray& ToByteArray() const {
-				return _buffer;
+            int32_t WriteVarint(uint64_t value) {
+				int32_t size = 0;
+				while ( value >= 0x80 ) {
+					_buffer->push_back(static_cast<char>((value & 0x7f) | 0x80));
+					value >>= 7;
+					size ++;
+				}
+				_buffer->push_back(static_cast<char>(value));
+
+				return size + 1;
 			}
 
+			// Zigzag maps small negative numbers to small unsigned ones: 0, -1, 1, -2... -> 0, 1, 2, 3...
+            int32_t WriteSignedVarint(int64_t value) {
+				return WriteVarint(ZigZag(value));
+			}
+
+            static uint64_t ZigZag(int64_t value) {
+				return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+			}
+
+            static int32_t GetVarintSize(uint64_t value) {
+				int32_t size = 1;
+				while ( value >= 0x80 ) {
+					value >>= 7;
+					size ++;
+				}
+
+				return size;
+			}
+
+			// Overwrites bytes which have already been written, e.g. a length prefix
+			// whose value is only known once the rest of the frame is written.
+			template <class T>
+            void Patch(int32_t pos, const T& value) {
+				memcpy(_buffer->data() + pos, &value, sizeof(T));
+			}
+
+            void Reserve(int32_t size) {
+				_buffer->reserve(size);
+			}
+
+			const ByteArray& ToByteArray() const {
+				return *_buffer;
+			}
 
             int32_t Tell() const {
-				return _buffer.size();
+				return _buffer->size();
 			}
 
 		private:
-			ByteArray _buffer;
+			ByteArray _ownedBuffer;
+			ByteArray* _buffer;
 		};
 
 	}
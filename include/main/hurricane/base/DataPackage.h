@@ -22,9 +22,11 @@
 #include <sstream>
 #include <string>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include "hurricane/base/ByteArray.h"
 #include "hurricane/base/Variant.h"
 
@@ -34,6 +36,8 @@ namespace hurricane {
         public:
             virtual int32_t Read(ByteArrayReader& reader, Variant& variant) = 0;
             virtual int32_t Write(ByteArrayWriter& writer, const Variant& variant) = 0;
+            // Number of bytes Write will produce for the variant, used to pre-size buffers
+            virtual int32_t GetSize(const Variant& variant) const = 0;
         };
 
         class IntWritable : public Writable {
@@ -51,34 +55,184 @@ namespace hurricane {
 
                 return sizeof(int32_t);
             }
+
+            int32_t GetSize(const Variant&) const override {
+                return sizeof(int32_t);
+            }
+        };
+
+        // Fixed-width binary encoding for scalar variants. WireType is the type written on the
+        // wire, which lets booleans travel as a single well defined byte.
+        template <class ValueType, class WireType,
+            ValueType (Variant::*Getter)() const, void (Variant::*Setter)(ValueType)>
+        class FixedWritable : public Writable {
+        public:
+            int32_t Read(ByteArrayReader& reader, Variant& variant) override {
+                WireType value = reader.Read<WireType>();
+                (variant.*Setter)(static_cast<ValueType>(value));
+
+                return sizeof(WireType);
+            }
+
+            int32_t Write(ByteArrayWriter& writer, const Variant& variant) override {
+                WireType value = static_cast<WireType>((variant.*Getter)());
+                writer.Write(value);
+
+                return sizeof(WireType);
+            }
+
+            int32_t GetSize(const Variant&) const override {
+                return sizeof(WireType);
+            }
         };
 
+        typedef FixedWritable<bool, int8_t,
+            &Variant::GetBooleanValue, &Variant::SetBooleanValue> BooleanWritable;
+        typedef FixedWritable<float, float,
+            &Variant::GetFloatValue, &Variant::SetFloatValue> FloatWritable;
+        typedef FixedWritable<char, char,
+            &Variant::GetCharacterValue, &Variant::SetCharacterValue> CharacterWritable;
+        typedef FixedWritable<int8_t, int8_t,
+            &Variant::GetInt8Value, &Variant::SetInt8Value> Int8Writable;
+        typedef FixedWritable<int16_t, int16_t,
+            &Variant::GetInt16Value, &Variant::SetInt16Value> Int16Writable;
+        typedef FixedWritable<int64_t, int64_t,
+            &Variant::GetInt64Value, &Variant::SetInt64Value> Int64Writable;
+        typedef FixedWritable<double, double,
+            &Variant::GetDoubleValue, &Variant::SetDoubleValue> DoubleWritable;
+
         class StringWritable : public Writable {
         public:
             int32_t Read(ByteArrayReader& reader, Variant& variant) override {
                 int32_t size = reader.Read<int32_t>();
 
-                ByteArray bytes = reader.ReadData(size);
+                ByteArrayView bytes = reader.ReadView(size);
 
-                variant.SetStringValue(bytes.ToStdString());
+                variant.SetStringValue(bytes.data(), bytes.size());
 
                 return sizeof(int32_t) + bytes.size();
             }
 
             int32_t Write(ByteArrayWriter& writer, const Variant& variant) override {
-                std::string value = variant.GetStringValue();
+                const std::string& value = variant.GetStringValue();
 
                 writer.Write(int32_t(value.size()));
                 writer.Write(value.c_str(), value.size());
                 return sizeof(int32_t) + value.size();
             }
+
+            int32_t GetSize(const Variant& variant) const override {
+                return sizeof(int32_t) + variant.GetStringValue().size();
+            }
+        };
+
+        // Version 1 bodies: integers are zigzag LEB128 varints and string lengths are plain varints
+        template <class ValueType,
+            ValueType (Variant::*Getter)() const, void (Variant::*Setter)(ValueType)>
+        class VarintWritable : public Writable {
+        public:
+            int32_t Read(ByteArrayReader& reader, Variant& variant) override {
+                int32_t pos = reader.Tell();
+                (variant.*Setter)(static_cast<ValueType>(reader.ReadSignedVarint()));
+
+                return reader.Tell() - pos;
+            }
+
+            int32_t Write(ByteArrayWriter& writer, const Variant& variant) override {
+                return writer.WriteSignedVarint((variant.*Getter)());
+            }
+
+            int32_t GetSize(const Variant& variant) const override {
+                return ByteArrayWriter::GetVarintSize(ByteArrayWriter::ZigZag((variant.*Getter)()));
+            }
+        };
+
+        typedef VarintWritable<int32_t,
+            &Variant::GetIntValue, &Variant::SetIntValue> CompactIntWritable;
+        typedef VarintWritable<int16_t,
+            &Variant::GetInt16Value, &Variant::SetInt16Value> CompactInt16Writable;
+        typedef VarintWritable<int64_t,
+            &Variant::GetInt64Value, &Variant::SetInt64Value> CompactInt64Writable;
+
+        class CompactStringWritable : public Writable {
+        public:
+            int32_t Read(ByteArrayReader& reader, Variant& variant) override {
+                int32_t pos = reader.Tell();
+                int32_t size = static_cast<int32_t>(reader.ReadVarint());
+
+                ByteArrayView bytes = reader.ReadView(size);
+
+                variant.SetStringValue(bytes.data(), bytes.size());
+
+                return reader.Tell() - pos;
+            }
+
+            int32_t Write(ByteArrayWriter& writer, const Variant& variant) override {
+                const std::string& value = variant.GetStringValue();
+
+                int32_t size = writer.WriteVarint(value.size());
+                writer.Write(value.c_str(), value.size());
+                return size + value.size();
+            }
+
+            int32_t GetSize(const Variant& variant) const override {
+                const std::string& value = variant.GetStringValue();
+
+                return ByteArrayWriter::GetVarintSize(value.size()) + value.size();
+            }
         };
 
-        extern std::map<int8_t, std::shared_ptr<Writable>> Writables;
+        typedef std::map<int8_t, std::shared_ptr<Writable>> WritableMap;
+
+        // Writables of the fixed width (version 0) and the compact (version 1) body formats
+        extern WritableMap Writables;
+        extern WritableMap CompactWritables;
 
         class DataPackage {
         public:
-            DataPackage() : _version(0) {}
+            // The version byte of the head tells the receiver how the body is encoded
+            struct Version {
+                enum Values {
+                    Fixed = 0,
+                    Compact = 1
+                };
+            };
+
+            // The head is [int32 length, int8 version, int32 requestId], a response carries the
+            // request id of its request so that many requests can be in flight on one connection
+            static const int32_t REQUEST_ID_OFFSET = sizeof(int32_t) + sizeof(int8_t);
+            static const int32_t HEAD_SIZE = REQUEST_ID_OFFSET + sizeof(int32_t);
+
+            DataPackage() : _version(Version::Fixed), _requestId(0) {}
+
+            DataPackage(int8_t version) : _version(version), _requestId(0) {}
+
+            static int32_t PeekRequestId(const char* frame) {
+                int32_t requestId;
+                memcpy(&requestId, frame + REQUEST_ID_OFFSET, sizeof(requestId));
+
+                return requestId;
+            }
+
+            static void PatchRequestId(char* frame, int32_t requestId) {
+                memcpy(frame + REQUEST_ID_OFFSET, &requestId, sizeof(requestId));
+            }
+
+            int8_t GetVersion() const {
+                return _version;
+            }
+
+            void SetVersion(int8_t version) {
+                _version = version;
+            }
+
+            int32_t GetRequestId() const {
+                return _requestId;
+            }
+
+            void SetRequestId(int32_t requestId) {
+                _requestId = requestId;
+            }
 
             void AddVariant(const Variant& variant) {
                 _variants.push_back(variant);
@@ -89,74 +243,163 @@ namespace hurricane {
             }
 
             ByteArray Serialize() {
-                ByteArray body = SerializeBody();
-                ByteArray head = SerializeHead(body.size());
+                ByteArray buffer;
+                Serialize(buffer);
+
+                return buffer;
+            }
+
+            // Serializes into the caller's buffer in a single pass. The buffer is cleared but
+            // keeps its capacity, so a buffer reused across packages stops allocating once it
+            // has grown to the largest frame. Returns the size of the frame.
+            int32_t Serialize(ByteArray& buffer) {
+                return Serialize(buffer, [](ByteArrayWriter&) {});
+            }
+
+            // writeTail is called with the writer after the variants have been written and may
+            // append untagged data to the body, such as a tuple encoded by a TupleSchema.
+            template <class TailWriter>
+            int32_t Serialize(ByteArray& buffer, TailWriter writeTail) {
+                buffer.clear();
+
+                ByteArrayWriter writer(buffer);
+                writer.Reserve(GetHeadSize() + GetBodySize());
+
+                SerializeHead(writer);
+                SerializeBody(writer);
+                writeTail(writer);
+
+                _length = writer.Tell();
+                writer.Patch(0, _length);
 
-                return head + body;
+                return _length;
             }
 
             void Deserialize(const ByteArray& data) {
-                ByteArrayReader reader(data);
+                Deserialize(data.data(), data.size());
+            }
+
+            // Decodes the package straight out of the caller's buffer, e.g. the buffer handed
+            // to a data indication handler, without copying the frame first.
+            void Deserialize(const char* data, int32_t size) {
+                Deserialize(data, size, -1);
+            }
 
+            // Decodes the head and at most maxVariants variants, all of them if maxVariants is
+            // negative, and returns the part of the body which has not been decoded yet.
+            ByteArrayView Deserialize(const char* data, int32_t size, int32_t maxVariants) {
+                ByteArrayReader reader(data, size);
                 DeserializeHead(reader);
-                DeserializeBody(reader);
+
+                int32_t length = std::min(_length, size);
+                if ( length < reader.Tell() ) {
+                    return ByteArrayView();
+                }
+
+                return DeserializeVariants(
+                    ByteArrayView(data + reader.Tell(), length - reader.Tell()), maxVariants);
+            }
+
+            // Continues decoding a body returned by Deserialize
+            ByteArrayView DeserializeVariants(const ByteArrayView& body, int32_t maxVariants = -1) {
+                ByteArrayReader reader(body);
+
+                while ( reader.Tell() < reader.GetSize() && maxVariants != 0 ) {
+                    _variants.push_back(Variant());
+                    DeserializeVariant(reader, _variants.back());
+
+                    if ( maxVariants > 0 ) {
+                        maxVariants --;
+                    }
+                }
+
+                return ByteArrayView(body.data() + reader.Tell(), body.size() - reader.Tell());
             }
 
         private:
-            ByteArray SerializeBody() {
-                ByteArrayWriter bodyWriter;
+            int32_t GetHeadSize() const {
+                return HEAD_SIZE;
+            }
+
+            int32_t GetBodySize() const {
+                int32_t bodySize = 0;
                 for ( const Variant& variant : _variants ) {
-                    SerializeVariant(bodyWriter, variant);
+                    int8_t typeCode = 0;
+                    bodySize += sizeof(int8_t) + FindWritable(variant, &typeCode)->GetSize(variant);
                 }
-                return bodyWriter.ToByteArray();
+
+                return bodySize;
             }
 
-            ByteArray SerializeHead(int32_t bodySize) {
-                ByteArrayWriter headWriter;
-                _length = sizeof(int32_t) + sizeof(_version) + bodySize;
-                headWriter.Write(_length);
-                headWriter.Write(_version);
-                ByteArray head = headWriter.ToByteArray();
+            void SerializeBody(ByteArrayWriter& writer) {
+                for ( const Variant& variant : _variants ) {
+                    SerializeVariant(writer, variant);
+                }
+            }
 
-                return head;
+            // The length is written as a placeholder and patched once the body is written
+            void SerializeHead(ByteArrayWriter& writer) {
+                writer.Write(int32_t(0));
+                writer.Write(_version);
+                writer.Write(_requestId);
             }
 
             void DeserializeHead(ByteArrayReader& reader) {
                 _length = reader.Read<int32_t>();
                 _version = reader.Read<int8_t>();
+                _requestId = reader.Read<int32_t>();
             }
 
-            void DeserializeBody(ByteArrayReader& reader) {
-                while ( reader.Tell() < _length ) {
-                    Variant variant = DeserializeVariant(reader);
-                    _variants.push_back(variant);
+            void DeserializeVariant(ByteArrayReader& reader, Variant& variant) {
+                int8_t typeCode = reader.Read<int8_t>();
+                WritableMap& writables = GetWritables();
+                auto writable = writables.find(typeCode);
+                if ( writable == writables.end() ) {
+                    reader.Seek(IODevice::SeekMode::Set, reader.GetSize());
+                    return;
                 }
+
+                writable->second->Read(reader, variant);
             }
 
-            Variant DeserializeVariant(ByteArrayReader& reader) {
-                Variant variant;
+            void SerializeVariant(ByteArrayWriter& writer, const Variant& variant) {
+                int8_t typeCode = 0;
+                Writable* writable = FindWritable(variant, &typeCode);
 
-                if ( reader.Tell() >= _length ) {
-                    return variant;
+                writer.Write<int8_t>(typeCode);
+                writable->Write(writer, variant);
+            }
+
+            // An Invalid variant has neither a type code nor a writable, the package can not be
+            // serialized then. Throws before anything was written, as the body size is taken first.
+            Writable* FindWritable(const Variant& variant, int8_t* typeCode) const {
+                auto code = Variant::TypeCodes.find(variant.GetType());
+                if ( code == Variant::TypeCodes.end() ) {
+                    throw "Variant type not serializable";
                 }
 
-                int8_t typeCode = reader.Read<int8_t>();
-                std::shared_ptr<Writable> writable = Writables[typeCode];
-                writable->Read(reader, variant);
+                WritableMap& writables = GetWritables();
+                auto writable = writables.find(code->second);
+                if ( writable == writables.end() ) {
+                    throw "Variant type not serializable";
+                }
+
+                *typeCode = code->second;
 
-                return variant;
+                return writable->second.get();
             }
 
-            void SerializeVariant(ByteArrayWriter& writer, const Variant& variant) {
-                Variant::Type type = variant.GetType();
-                int8_t typeCode = Variant::TypeCodes[type];
-                std::shared_ptr<Writable> writable = Writables[typeCode];
+            // Unknown versions decode with the fixed table, the length prefix keeps framing intact
+            WritableMap& GetWritables() const {
+                if ( _version == Version::Compact ) {
+                    return CompactWritables;
+                }
 
-                writer.Write<int8_t>(typeCode);
-                writable->Write(writer, variant);
+                return Writables;
             }
 
             int8_t _version;
+            int32_t _requestId;
             int32_t _length;
             std::vector<Variant> _variants;
         };
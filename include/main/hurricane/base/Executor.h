@@ -19,6 +19,9 @@
 #pragma once
 
 #include "hurricane/base/ITask.h"
+#include "hurricane/base/TaskScheduler.h"
+#include "hurricane/base/Placement.h"
+#include "hurricane/base/IdleStrategy.h"
 #include "hurricane/message/MessageLoop.h"
 
 #include <thread>
@@ -27,12 +30,13 @@
 #include <iostream>
 #include <mutex>
 #include <functional>
+#include <chrono>
 
 namespace hurricane {
 namespace base {
 
 template <class TaskType>
-class Executor {
+class Executor : public ScheduledTask {
 public:
     // status表示执行器的状态,某个执行器可能在执行任务,此时状态为Running ,否则为Stopping
     enum class Status {
@@ -40,26 +44,47 @@ public:
         Running
     };
 
-    Executor() : _status(Status::Stopping) {
+    Executor() : _status(Status::Stopping), _placement(nullptr), _idleDelay(MinIdleDelay()) {
     }
 
     virtual ~Executor() {}
 
     // 负责启动任务,其实就是设置一下任务名,保存用户传递的任务,并创建一个新的线程,准备执行任务,入口为StartThread
     void StartTask(const std::string& taskName, TaskType* task) {
-		_messageLoop.MessageMap(BoltMessage::MessageType::Data,
-			this, &BoltMessageLoop::OnData);
         _taskName = taskName;
         _task = std::shared_ptr<TaskType>(task);
 
 		_thread = std::thread(std::bind(&Executor::StartThread, this));
     }
 
+    // Runs the executor in slices on the workers of scheduler instead of on a thread of its own,
+    // so that many executors share a few threads. The thread messages of Windows can only be
+    // read by the thread which created the loop, so there the executor keeps its own thread.
+    void StartTask(const std::string& taskName, TaskType* task, TaskScheduler* scheduler) {
+#ifdef WIN32
+        StartTask(taskName, task);
+#else
+        _taskName = taskName;
+        _task = std::shared_ptr<TaskType>(task);
+
+        _messageLoop.SetWakeupHandler([this]() {
+            Notify();
+        });
+        scheduler->Schedule(this, _placement ? _placement->GetNode(taskName) : -1);
+#endif
+    }
+
     // 停止
     virtual void StopTask() {
 		_messageLoop.Stop();
     }
 
+    // The thread of the executor is pinned to the node of its task before the task is created,
+    // a scheduled executor runs on the workers of its scheduler placed on that node
+    void SetPlacement(Placement* placement) {
+        _placement = placement;
+    }
+
     Status GetStatus() const {
         return _status;
     }
@@ -71,6 +96,69 @@ public:
 protected:
 	virtual void OnCreate() = 0;
 	virtual void OnStop() = 0;
+
+    // A scheduled executor leaves its messages in the queue while it is not ready
+    virtual bool IsReady() {
+        return true;
+    }
+
+    // Called on a scheduled executor once its queue is empty, returns a ScheduledTask::Result
+    virtual int32_t OnIdle(std::chrono::microseconds*) {
+        return Result::Wait;
+    }
+
+    // Delay of a scheduled executor which found nothing to do, it doubles up to the longest
+    // sleep of IdleStrategy until ResetIdleDelay is called
+    std::chrono::microseconds NextIdleDelay() {
+        std::chrono::microseconds delay = _idleDelay;
+        if ( _idleDelay.count() * 2 <= IdleStrategy::DEFAULT_MAX_SLEEP_MICROSECONDS ) {
+            _idleDelay *= 2;
+        }
+
+        return delay;
+    }
+
+    void ResetIdleDelay() {
+        _idleDelay = MinIdleDelay();
+    }
+
+    // Runs a batch of messages, the first slice creates the executor and the stop message ends it
+    int32_t RunSlice(std::chrono::microseconds* delay) override {
+#ifdef WIN32
+        return Result::Done;
+#else
+        if ( _status == Status::Stopping ) {
+            _status = Status::Running;
+            OnCreate();
+        }
+
+        if ( !IsReady() ) {
+            *delay = NextIdleDelay();
+            return Result::Delay;
+        }
+
+        bool stopped = false;
+        int32_t batchSize = hurricane::message::MessageLoop::BATCH_SIZE;
+        int32_t handled = _messageLoop.Poll(batchSize, &stopped);
+        if ( stopped ) {
+            OnStop();
+            _status = Status::Stopping;
+
+            return Result::Done;
+        }
+
+        if ( handled > 0 ) {
+            ResetIdleDelay();
+        }
+        // The queue may still hold messages, the other tasks of the worker get their turn first
+        if ( handled == batchSize ) {
+            return Result::Continue;
+        }
+
+        return OnIdle(delay);
+#endif
+    }
+
     std::shared_ptr<TaskType> _task;
 	hurricane::message::MessageLoop _messageLoop;
 
@@ -82,9 +170,19 @@ private:
     3、启动消息队列,消息队列结束执行OnStop停止执行器
     4、等待Manager的下一次调度
     */
+    static std::chrono::microseconds MinIdleDelay() {
+        // The duration takes its count by reference, which needs a definition of the constant
+        int32_t microseconds = IdleStrategy::DEFAULT_MIN_SLEEP_MICROSECONDS;
+        return std::chrono::microseconds(microseconds);
+    }
+
     void StartThread() {
 		_status = Status::Running;
 
+        if ( _placement ) {
+            _placement->PinTask(_taskName);
+        }
+
 		OnCreate();
 		_messageLoop.Run();
 		OnStop();
@@ -95,6 +193,8 @@ private:
     std::thread _thread;
 	Status _status;
     std::string _taskName;
+    Placement* _placement;
+    std::chrono::microseconds _idleDelay;
 };
 
 }
@@ -0,0 +1,74 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include "hurricane/base/ByteArray.h"
+#include "hurricane/base/DataPackage.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace hurricane {
+    namespace base {
+        // Splits a byte stream into complete DataPackage frames using the length the frame head starts with.
+        // Frames which arrive in one piece are handed out in place, only a frame split across reads is buffered.
+        class FrameReassembler {
+        public:
+            // The frame is only valid during the call
+            typedef std::function<void(const char* frame, int32_t size)> FrameHandler;
+
+            static const int32_t LENGTH_SIZE = sizeof(int32_t);
+            static const int32_t HEAD_SIZE = DataPackage::HEAD_SIZE;
+            static const int32_t DEFAULT_MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+            FrameReassembler(int32_t maxFrameSize = DEFAULT_MAX_FRAME_SIZE) :
+                _maxFrameSize(maxFrameSize) {
+            }
+
+            // Calls handler for every frame completed by data. Returns false if the stream carries
+            // an invalid frame length, the buffered bytes are dropped in that case.
+            bool Feed(const char* data, int32_t size, FrameHandler handler);
+
+            int32_t GetPendingSize() const {
+                return int32_t(_buffer.size());
+            }
+
+            void Reset() {
+                _buffer.clear();
+            }
+
+        private:
+            static int32_t PeekLength(const char* data) {
+                int32_t length;
+                memcpy(&length, data, sizeof(length));
+
+                return length;
+            }
+
+            bool IsValidLength(int32_t length) const {
+                return length >= HEAD_SIZE && length <= _maxFrameSize;
+            }
+
+            int32_t _maxFrameSize;
+            // Holds the received part of a single incomplete frame
+            ByteArray _buffer;
+        };
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+namespace hurricane {
+namespace base {
+
+// Backs off a thread which found nothing to do. It spins first, then yields its time slice
+// and finally sleeps for periods doubling up to maxSleep, so that an idle task costs almost
+// no cpu while work arriving on a busy one is picked up within microseconds.
+class IdleStrategy {
+public:
+    IdleStrategy(int32_t maxSpins = DEFAULT_MAX_SPINS, int32_t maxYields = DEFAULT_MAX_YIELDS,
+        int32_t minSleepMicroseconds = DEFAULT_MIN_SLEEP_MICROSECONDS,
+        int32_t maxSleepMicroseconds = DEFAULT_MAX_SLEEP_MICROSECONDS) :
+        _maxSpins(maxSpins), _maxYields(maxYields),
+        _minSleep(minSleepMicroseconds), _maxSleep(maxSleepMicroseconds) {
+        Reset();
+    }
+
+    // Called every time the thread found nothing to do
+    void Idle() {
+        if ( _spins < _maxSpins ) {
+            _spins ++;
+        }
+        else if ( _yields < _maxYields ) {
+            _yields ++;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(_sleep);
+            _sleep = _sleep * 2 < _maxSleep ? _sleep * 2 : _maxSleep;
+        }
+    }
+
+    // Called once the thread did some work
+    void Reset() {
+        _spins = 0;
+        _yields = 0;
+        _sleep = _minSleep;
+    }
+
+    static const int32_t DEFAULT_MAX_SPINS = 100;
+    static const int32_t DEFAULT_MAX_YIELDS = 20;
+    static const int32_t DEFAULT_MIN_SLEEP_MICROSECONDS = 50;
+    static const int32_t DEFAULT_MAX_SLEEP_MICROSECONDS = 10000;
+
+private:
+    int32_t _maxSpins;
+    int32_t _maxYields;
+    std::chrono::microseconds _minSleep;
+    std::chrono::microseconds _maxSleep;
+    int32_t _spins;
+    int32_t _yields;
+    std::chrono::microseconds _sleep;
+};
+
+}
+}
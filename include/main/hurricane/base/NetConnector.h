@@ -19,17 +19,33 @@
 #pragma once
 
 #include "hurricane/base/NetAddress.h"
+#include "hurricane/base/FrameReassembler.h"
 #include "Meshy.h"
 
 #include <cstdint>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <future>
+#include <functional>
+#include <chrono>
 
-class NetConnector {
+// Has to be owned by a std::shared_ptr, the io loop only holds it weakly
+class NetConnector : public std::enable_shared_from_this<NetConnector> {
 public:
+    // Called on the io loop thread with the response frame, which is only valid during the call.
+    // buffer is null if the connection closed before the response arrived.
+    typedef std::function<void(const char* buffer, int32_t size)> ResponseHandler;
+
     NetConnector(const hurricane::base::NetAddress& host) :
-        _host(host) {
+        _host(host), _noDelay(false), _nextRequestId(0), _closed(false),
+        _responseTimeout(DEFAULT_RESPONSE_TIMEOUT_MILLISECONDS) {
     }
 
+    // Closes the connection, the requests still waiting for their responses fail
+    ~NetConnector();
+
     const hurricane::base::NetAddress& GetHost() const {
         return _host;
     }
@@ -39,9 +55,55 @@ public:
     }
 
     void Connect();
-    int32_t SendAndReceive(const char* buffer, int32_t size, char* resultBuffer, int32_t resultSize);
+
+    // Sends small frames at once instead of letting the kernel coalesce them,
+    // kept across Connect
+    void SetNoDelay(bool noDelay);
+
+    // Tags the frame with a new request id and returns without waiting for the response.
+    // Any number of requests may be in flight on the connection.
+    // The request id is written into the frame in place, so the frame is not copied.
+    // Returns the request id.
+    int32_t SendRequest(char* buffer, int32_t size, ResponseHandler handler);
+    // The future throws std::runtime_error if the connection closed before the response arrived
+    std::future<hurricane::base::ByteArray> SendRequest(char* buffer, int32_t size);
+    // Sends the frame with request id 0, the peer does not respond to it
+    void Send(char* buffer, int32_t size);
+
+    // Waits for the response at most for the response timeout,
+    // returns -1 if it timed out or the connection closed
+    int32_t SendAndReceive(char* buffer, int32_t size, char* resultBuffer, int32_t resultSize);
+
+    void SetResponseTimeout(std::chrono::milliseconds responseTimeout) {
+        _responseTimeout = responseTimeout;
+    }
+
+    static const int32_t DEFAULT_RESPONSE_TIMEOUT_MILLISECONDS = 30000;
+
+    // The connection closed, every request fails from now on
+    bool IsClosed() {
+        std::unique_lock<std::mutex> locker(_requestMutex);
+        return _closed;
+    }
+
+    // Bytes which have been sent but are still waiting for the socket
+    size_t GetSendQueueSize() const {
+        return _client ? _client->GetSendQueueSize() : 0;
+    }
 
 private:
+    void OnFrame(const char* frame, int32_t size);
+    void CancelRequest(int32_t requestId);
+    // Called once the connection closed, every pending request and every later one fails
+    void FailRequests();
+
     hurricane::base::NetAddress _host;
     std::shared_ptr<meshy::TcpClient> _client;
+    bool _noDelay;
+    hurricane::base::FrameReassembler _reassembler;
+    std::atomic<int32_t> _nextRequestId;
+    std::mutex _requestMutex;
+    std::map<int32_t, ResponseHandler> _pendingRequests;
+    bool _closed;
+    std::chrono::milliseconds _responseTimeout;
 };
@@ -35,6 +35,9 @@ typedef std::function<void(meshy::TcpStream* connection,
     const char* buffer, int32_t size)> 
         DataReceiver;
 
+// Called once a connection has been closed, the connection must not be used afterwards
+typedef std::function<void(meshy::TcpStream* connection)> DisconnectReceiver;
+
 // 网络监听器
 // 基于tcp/IP套接字的网络消息监听类,可以帮助我们进行网络监听
 class NetListener {
@@ -59,8 +62,18 @@ public:
         _receiver = receiver;
     }
 
+    // Has to be registered before StartListen
+    void OnDisconnect(DisconnectReceiver receiver) {
+        _disconnectReceiver = receiver;
+    }
+
+    // Closes a connection whose peer broke the protocol, the disconnect receiver
+    // is called once the network loop dropped it
+    void Close(meshy::TcpStream* connection);
+
 private:
     hurricane::base::NetAddress _host;
     DataReceiver _receiver;
+    DisconnectReceiver _disconnectReceiver;
     meshy::TcpServer _server;
 };
\ No newline at end of file
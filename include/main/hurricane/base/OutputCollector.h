@@ -20,6 +20,17 @@
 
 #include "hurricane/base/Values.h"
 #include "hurricane/message/SupervisorCommander.h"
+#include "hurricane/base/IdleStrategy.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdint>
 
 namespace hurricane {
 
@@ -27,8 +38,14 @@ namespace hurricane {
     class ITopology;
     }
 
+    namespace bolt {
+    class BoltExecutor;
+    }
+
     namespace base {
 
+        class LingerTimer;
+
 		// 数据收集器-作用比较单一,负责进行数据传递(基础类型之一)
         class OutputCollector {
         public:
@@ -54,27 +71,112 @@ namespace hurricane {
             # para2 消息发送策略,同上
             */
             OutputCollector(const std::string& src, int strategy) :
-                _src(src), _strategy(strategy), _commander(nullptr) {}
+                _src(src), _strategy(strategy), _commander(nullptr), _localDestination(nullptr),
+                _batchSize(DEFAULT_BATCH_SIZE), _batchLinger(DEFAULT_BATCH_LINGER),
+                _batchBytes(0), _batchBytesThreshold(DEFAULT_BATCH_BYTES),
+                _minBatchBytes(DEFAULT_MIN_BATCH_BYTES), _maxBatchBytes(DEFAULT_MAX_BATCH_BYTES),
+                _noDelay(false), _sendQueueHighWatermark(DEFAULT_SEND_QUEUE_HIGH_WATERMARK),
+                _sendQueueLowWatermark(DEFAULT_SEND_QUEUE_LOW_WATERMARK), _sendQueueThrottled(false),
+                _emittedCount(0), _localPendingCount(std::make_shared<std::atomic<int64_t>>(0)) {}
+            virtual ~OutputCollector();
 
 			// 作用:发送一个元祖,具体实现中会根据数据收集器的发送策略发送元祖数据
             virtual void Emit(const Values& values);
+            void Emit(Values&& values);
+			// Sends the tuples accumulated for the global destination immediately
+            void Flush();
+
+			// The destination can not keep up: a local destination executor is overloaded or
+            // sendQueueHighWatermark bytes wait to be sent on the connection. The connection
+            // stays throttled until its send queue drained to sendQueueLowWatermark bytes.
+            // It is also throttled while its ack window is full, the next frame would block.
+            bool IsThrottled();
+            // Blocks the emitting task, backing off, until the collector is not throttled anymore
+            void WaitWhileThrottled();
+
+            // Tuples emitted since the collector was created
+            uint64_t GetEmittedCount() const {
+                return _emittedCount;
+            }
+
+            // Tuples emitted but not acknowledged by their destination yet: the ones waiting in
+            // the batch, the ones sent and not acknowledged by the peer supervisor and the ones
+            // a local destination executor did not execute yet
+            int64_t GetPendingCount();
+
+            void SetSendQueueWatermarks(size_t highWatermark, size_t lowWatermark) {
+                _sendQueueHighWatermark = highWatermark;
+                _sendQueueLowWatermark = lowWatermark < highWatermark ? lowWatermark : highWatermark;
+            }
+
+			// Tuples sent with the global strategy are accumulated and sent as one frame
+            // once batchSize tuples are pending, their size reaches the byte threshold
+            // or the oldest one waited for batchLinger.
+            // A batch size of 1 sends every tuple on its own.
+            void SetBatchSize(size_t batchSize) {
+                _batchSize = batchSize > 0 ? batchSize : 1;
+            }
+
+            void SetBatchLinger(std::chrono::milliseconds batchLinger) {
+                _batchLinger = batchLinger;
+            }
+
+            // The byte threshold follows the arrival rate between minBytes and maxBytes. It doubles
+            // whenever a batch fills up before its linger expires and falls back to what arrived
+            // within one linger otherwise, so slow flows are not held back waiting for bytes.
+            void SetBatchBytes(size_t minBytes, size_t maxBytes) {
+                std::unique_lock<std::mutex> locker(_batchMutex);
+                _minBatchBytes = minBytes > 0 ? minBytes : 1;
+                _maxBatchBytes = maxBytes > _minBatchBytes ? maxBytes : _minBatchBytes;
+                _batchBytesThreshold = std::min(std::max(_batchBytesThreshold, _minBatchBytes), _maxBatchBytes);
+            }
+
 			// 作用:设置命令执行器,命令执行器的作用:与网络上的其他节点进行通信
             // 这里我们已经将所有的原始数据抽象为高层的命令,而将通信层的负责细节隐藏在底层
             void SetCommander(hurricane::message::SupervisorCommander* commander) {
+                std::unique_lock<std::mutex> locker(_batchMutex);
+                SendBatch();
+
                 if ( _commander ) {
                     delete _commander;
                 }
 
                 _commander = commander;
+                _localDestination = nullptr;
+                // A new connection starts with the kernel defaults
+                _noDelay = false;
+            }
+
+            // A destination executor running in this process receives the tuples directly
+            // in its message loop, without serializing them or going through the network
+            void SetLocalDestination(bolt::BoltExecutor* executor) {
+                std::unique_lock<std::mutex> locker(_batchMutex);
+                SendBatch();
+
+                if ( _commander ) {
+                    delete _commander;
+                    _commander = nullptr;
+                }
+
+                _localDestination = executor;
             }
 
 			// _taskIndex是OutputCollector每次发送元祖数据时目的地的任务编号.
             // 一个Manager会管理多个任务,而Commander之关联到了某个Manager节点,但是将数据分发给哪个任务是不知道的,因此我们需要使用taskIndex做定位
             // Manager的位置和taskIndex的关系就像主机名和端口号,决定了发送的目标任务
             void SetTaskIndex(int taskIndex) {
+                std::unique_lock<std::mutex> locker(_batchMutex);
+                SendBatch();
+
                 _taskIndex = taskIndex;
             }
 
+            // Sends to the task destIndex of the supervisor at address, directly if the task runs
+            // in this process. Only a fixed destination keeps its connection long enough to benefit
+            // from the schema of fields and from acknowledging its tuples in windows.
+            void SetDestination(const NetAddress& address, int destIndex, const std::string& supervisorName,
+                const Fields& fields, int32_t ackWindowTuples);
+
 			// groupField给分组策略使用,分组策略需要根据这个groupField将数据发送到某个固定的数据处理单元
             // groupField是字段在任务定义中的字段编号,这个字段编号结合字段列表就可以确定是哪一个字段
             void SetGroupField(int groupField) {
@@ -96,12 +198,55 @@ namespace hurricane {
 			// 根据字段选择元组发送的目标消息处理单元
             virtual void GroupDestination() {};
 
+            static const size_t DEFAULT_BATCH_SIZE = 1024;
+            static const std::chrono::milliseconds DEFAULT_BATCH_LINGER;
+            static const size_t DEFAULT_BATCH_BYTES = 16 * 1024;
+            static const size_t DEFAULT_MIN_BATCH_BYTES = 1024;
+            static const size_t DEFAULT_MAX_BATCH_BYTES = 1024 * 1024;
+            static const size_t DEFAULT_SEND_QUEUE_HIGH_WATERMARK = 8 * 1024 * 1024;
+            static const size_t DEFAULT_SEND_QUEUE_LOW_WATERMARK = 2 * 1024 * 1024;
+
         private:
+            struct SendReason {
+                enum Values {
+                    Forced = 0,
+                    Full = 1,
+                    Linger = 2
+                };
+            };
+
+            // Called with _batchMutex held
+            void SendBatch(int reason = SendReason::Forced);
+            // Called by the linger timer once the deadline of a batch passed
+            void SendLingeringBatch();
+            // Sends one tuple to the current destination, locally or through the commander
+            void SendTuple(Values&& values);
+
             std::string _src;// 发送源的名称
             int _strategy;// 策略编号
             int _taskIndex;// 目标任务编号
             hurricane::message::SupervisorCommander* _commander;// 命令发送器,默认为空指针
+            bolt::BoltExecutor* _localDestination;// 同一进程中的目标执行器,设置后不再使用命令发送器
             int _groupField;// 分组策略中,指定了分组使用的字段编号
+
+            std::vector<Values> _batch;
+            size_t _batchSize;
+            std::chrono::milliseconds _batchLinger;
+            std::chrono::steady_clock::time_point _batchDeadline;
+            size_t _batchBytes;// 当前批次的估计字节数
+            size_t _batchBytesThreshold;
+            size_t _minBatchBytes;
+            size_t _maxBatchBytes;
+            bool _noDelay;// 当前连接是否关闭了Nagle算法
+            size_t _sendQueueHighWatermark;
+            size_t _sendQueueLowWatermark;
+            bool _sendQueueThrottled;
+            std::atomic<uint64_t> _emittedCount;
+            // Shared with the messages handed to the local destination, which may outlive the collector
+            std::shared_ptr<std::atomic<int64_t>> _localPendingCount;
+            std::mutex _batchMutex;
+
+            friend class LingerTimer;
         };
 
     }
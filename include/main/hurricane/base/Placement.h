@@ -0,0 +1,86 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace hurricane {
+    namespace base {
+        // Places the threads of a supervisor on the cores of its NUMA nodes. The executors of tasks
+        // which send tuples to each other are kept on one node, the network loops and the workers
+        // of a scheduler are spread across the nodes.
+        // Memory is allocated on the node of the thread touching it first, so an executor built by
+        // RunOnNode and run by a pinned thread keeps its queues and buffers in node local memory.
+        class Placement {
+        public:
+            struct Policy {
+                enum Values {
+                    // Threads are left to the operating system
+                    None,
+                    // A thread may run on any core of its node
+                    Node,
+                    // Every thread is pinned to a core of its node
+                    Core
+                };
+            };
+
+            Placement(int32_t policy = Policy::None);
+
+            int32_t GetPolicy() const {
+                return _policy;
+            }
+
+            int32_t GetNodeCount() const {
+                return int32_t(_nodeCpus.size());
+            }
+
+            // Assigns the tasks of every connected part of the network to one node,
+            // the largest parts first and each to the node with the fewest tasks
+            void Plan(const std::map<std::string, std::vector<std::string>>& network);
+
+            // Tasks which were not planned are on node 0
+            int32_t GetNode(const std::string& taskName) const;
+
+            // Pins the calling thread, which runs an executor of the task
+            void PinTask(const std::string& taskName);
+            // Pins the calling thread, the index-th of a group of threads shared by all the tasks,
+            // to node index modulo the node count, so that the group is spread evenly
+            void PinThread(int32_t index);
+
+            // Runs function on a thread placed on node and waits for it
+            void RunOnNode(int32_t node, std::function<void()> function);
+
+        private:
+            // anyCore lets the thread run on any core of the node whatever the policy
+            void Pin(int32_t node, bool anyCore);
+
+            int32_t _policy;
+            std::vector<std::vector<int32_t>> _nodeCpus;
+            std::map<std::string, int32_t> _taskNodes;
+
+            std::mutex _nextCpusMutex;
+            std::vector<size_t> _nextCpus;
+        };
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include "hurricane/base/Placement.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace hurricane {
+    namespace base {
+        class TaskScheduler;
+
+        // A task run in slices by the workers of a TaskScheduler. Notify makes the task runnable,
+        // a task is never run by two workers at the same time and a notification arriving while
+        // it runs gets it another slice.
+        class ScheduledTask {
+        public:
+            struct Result {
+                enum Values {
+                    // Nothing to do until the next notification
+                    Wait,
+                    // Work is left, the task is queued again behind the other tasks of the worker
+                    Continue,
+                    // Runs again after the delay set by RunSlice or at the next notification
+                    Delay,
+                    // The task is never run again
+                    Done
+                };
+            };
+
+            ScheduledTask() : _scheduler(nullptr), _state(State::Idle), _node(-1) {
+            }
+
+            virtual ~ScheduledTask() {}
+
+            // May be called by any thread, it does nothing before the task was scheduled
+            void Notify();
+
+            bool IsScheduled() const {
+                return _scheduler.load(std::memory_order_acquire) != nullptr;
+            }
+
+        protected:
+            // Returns a Result, delay only has to be set for Result::Delay
+            virtual int32_t RunSlice(std::chrono::microseconds* delay) = 0;
+
+        private:
+            struct State {
+                enum Values {
+                    Idle,
+                    Queued,
+                    Running,
+                    // Notified while it was running
+                    Notified,
+                    Done
+                };
+            };
+
+            std::atomic<TaskScheduler*> _scheduler;
+            std::atomic<int32_t> _state;
+            // Only run by the workers of this node, -1 for any worker
+            int32_t _node;
+
+            friend class TaskScheduler;
+        };
+
+        // Runs many tasks on a fixed pool of workers. Every worker takes the tasks from the front of
+        // its own queue, a worker which ran out of tasks steals them from the back of the others.
+        // A task notified by a worker is queued on that worker, so a tuple handed to a co-located
+        // executor is usually handled while it is still in the cache.
+        // A task scheduled on a node stays with the workers placed on that node.
+        class TaskScheduler {
+        public:
+            // 0 starts one worker per hardware thread, the workers are spread across the nodes
+            // by placement if there is one
+            TaskScheduler(int32_t workerCount = 0, Placement* placement = nullptr);
+            ~TaskScheduler();
+
+            TaskScheduler(const TaskScheduler&) = delete;
+            const TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+            // The first slice of the task is run as soon as a worker is free. A task on node is only
+            // run by the workers of the node, it may run on any worker if none is placed there.
+            void Schedule(ScheduledTask* task, int32_t node = -1);
+            // Joins the workers, the tasks still queued are not run anymore
+            void Stop();
+
+            int32_t GetWorkerCount() const {
+                return int32_t(_workers.size());
+            }
+
+            // Rounds a worker looks for tasks to steal before it sleeps
+            static const int32_t STEAL_ROUNDS = 64;
+
+        private:
+            struct Worker {
+                std::mutex mutex;
+                std::deque<ScheduledTask*> tasks;
+                std::thread thread;
+                // -1 if the worker is not placed
+                int32_t node;
+            };
+
+            void Submit(ScheduledTask* task);
+            // Round robin over the workers of node, over all workers for -1
+            int32_t NextWorker(int32_t node);
+            void Push(int32_t workerIndex, ScheduledTask* task);
+            ScheduledTask* Pop(int32_t workerIndex);
+            ScheduledTask* Steal(int32_t workerIndex);
+            void RunTask(int32_t workerIndex, ScheduledTask* task);
+            void WaitForTask();
+            // Returns -1 if the calling thread is not a worker
+            int32_t GetCurrentWorker() const;
+
+            void AddTimer(ScheduledTask* task, std::chrono::microseconds delay);
+            void CancelTimers(ScheduledTask* task);
+
+            void WorkerMain(int32_t workerIndex);
+            void TimerMain();
+
+            std::vector<std::unique_ptr<Worker>> _workers;
+            Placement* _placement;
+            std::atomic<bool> _running;
+            std::atomic<uint32_t> _nextWorker;
+
+            // Tasks waiting in all queues, sleeping workers are only woken up when they are not 0
+            std::atomic<int64_t> _queuedCount;
+            std::atomic<int32_t> _sleepingCount;
+            std::mutex _sleepMutex;
+            std::condition_variable _sleepCondition;
+
+            // Delayed tasks, they are notified by the timer thread
+            std::multimap<std::chrono::steady_clock::time_point, ScheduledTask*> _timers;
+            std::mutex _timerMutex;
+            std::condition_variable _timerCondition;
+            std::thread _timerThread;
+
+            friend class ScheduledTask;
+        };
+    }
+}
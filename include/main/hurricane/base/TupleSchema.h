@@ -0,0 +1,138 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include "hurricane/base/ByteArray.h"
+#include "hurricane/base/Fields.h"
+#include "hurricane/base/Values.h"
+#include "hurricane/base/Variant.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace hurricane {
+    namespace base {
+        // Encodes a single field of a tuple without any type code, the type is known from the schema
+        class ValueCodec {
+        public:
+            virtual ~ValueCodec() {}
+
+            // Returns false if the reader ran out before the whole value was read
+            virtual bool Read(ByteArrayReader& reader, Value& value) const = 0;
+            virtual void Write(ByteArrayWriter& writer, const Value& value) const = 0;
+            virtual int32_t GetSize(const Value& value) const = 0;
+
+            static const ValueCodec* GetCodec(Value::Type type);
+        };
+
+        template <class ValueType, ValueType (Value::*Getter)() const>
+        class FixedValueCodec : public ValueCodec {
+        public:
+            bool Read(ByteArrayReader& reader, Value& value) const override {
+                if ( reader.GetSize() - reader.Tell() < int32_t(sizeof(ValueType)) ) {
+                    return false;
+                }
+
+                value = Value(reader.Read<ValueType>());
+
+                return true;
+            }
+
+            void Write(ByteArrayWriter& writer, const Value& value) const override {
+                writer.Write((value.*Getter)());
+            }
+
+            int32_t GetSize(const Value&) const override {
+                return sizeof(ValueType);
+            }
+        };
+
+        class StringValueCodec : public ValueCodec {
+        public:
+            bool Read(ByteArrayReader& reader, Value& value) const override {
+                if ( reader.GetSize() - reader.Tell() < int32_t(sizeof(int32_t)) ) {
+                    return false;
+                }
+
+                int32_t size = reader.Read<int32_t>();
+                if ( size < 0 || reader.GetSize() - reader.Tell() < size ) {
+                    return false;
+                }
+
+                ByteArrayView bytes = reader.ReadView(size);
+                value = Value(bytes.ToStdString());
+
+                return true;
+            }
+
+            void Write(ByteArrayWriter& writer, const Value& value) const override {
+                const std::string& stringValue = value.ToString();
+
+                writer.Write(int32_t(stringValue.size()));
+                writer.Write(stringValue.c_str(), stringValue.size());
+            }
+
+            int32_t GetSize(const Value& value) const override {
+                return sizeof(int32_t) + value.ToString().size();
+            }
+        };
+
+        // The (field, type) layout of the tuples on one stream. The schema is sent once per
+        // connection, after that tuples are written as bare values in schema order and are
+        // decoded through the codec array built here, without any per-field type lookup.
+        class TupleSchema {
+        public:
+            TupleSchema() = default;
+            // The field names come from ITask::DeclareFields and the types from the first tuple
+            TupleSchema(const Fields& fields, const Values& values);
+
+            const Fields& GetFields() const {
+                return _fields;
+            }
+
+            const std::vector<Value::Type>& GetTypes() const {
+                return _types;
+            }
+
+            bool IsEmpty() const {
+                return _types.empty();
+            }
+
+            // Whether the tuple can be encoded with this schema, tuples which cannot are sent tagged
+            bool Accepts(const Values& values) const;
+
+            int32_t GetSize(const Values& values) const;
+            void Encode(ByteArrayWriter& writer, const Values& values) const;
+            // Returns false if the reader ran out before the whole tuple was read
+            bool Decode(ByteArrayReader& reader, Values& values) const;
+
+            // The schema travels as the arguments of a Schema command: name, type, name, type...
+            // Arguments of other types give an empty schema.
+            Variants ToVariants() const;
+            static TupleSchema FromVariants(const Variants& variants, size_t offset);
+
+        private:
+            void BuildCodecs();
+
+            Fields _fields;
+            std::vector<Value::Type> _types;
+            std::vector<const ValueCodec*> _codecs;
+        };
+    }
+}
@@ -136,6 +136,8 @@ namespace hurricane {
                 if ( _type != Type::Boolean ) {
                     throw TypeMismatchException("The type of value is not boolean");
                 }
+
+                return _value.booleanValue;
             }
 
             int8_t ToInt8() const {
@@ -178,6 +180,22 @@ namespace hurricane {
                 return _value.characterValue;
             }
 
+            float ToFloat() const {
+                if ( _type != Type::Float ) {
+                    throw TypeMismatchException("The type of value is not float");
+                }
+
+                return _value.floatValue;
+            }
+
+            double ToDouble() const {
+                if ( _type != Type::Double ) {
+                    throw TypeMismatchException("The type of value is not double");
+                }
+
+                return _value.doubleValue;
+            }
+
             const std::string& ToString() const {
                 if ( _type != Type::String ) {
                     throw TypeMismatchException("The type of value is not string");
@@ -186,6 +204,10 @@ namespace hurricane {
                 return _stringValue;
             }
 
+            Type GetType() const {
+                return _type;
+            }
+
             Variant ToVariant() const;
             static Value FromVariant(const Variant& variant);
 
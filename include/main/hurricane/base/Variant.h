@@ -34,34 +34,49 @@ namespace hurricane {
 				Boolean,
 				Float,
 				String,
+				Character,
+				Int8,
+				Int16,
+				Int64,
+				Double
 			};
 
 			static std::map<Type, int8_t> TypeCodes;
 			static std::map<Type, std::string> TypeNames;
 
-			Variant() : _type(Type::Invalid) {}
+			Variant() : _type(Type::Invalid), _int64Value(0) {}
 			Variant(int32_t intValue) : _type(Type::Integer), _intValue(intValue) {}
+			Variant(bool boolValue) : _type(Type::Boolean), _boolValue(boolValue) {}
+			Variant(char charValue) : _type(Type::Character), _charValue(charValue) {}
+			Variant(int8_t int8Value) : _type(Type::Int8), _int8Value(int8Value) {}
+			Variant(int16_t int16Value) : _type(Type::Int16), _int16Value(int16Value) {}
+			Variant(int64_t int64Value) : _type(Type::Int64), _int64Value(int64Value) {}
+			Variant(float floatValue) : _type(Type::Float), _floatValue(floatValue) {}
+			Variant(double doubleValue) : _type(Type::Double), _doubleValue(doubleValue) {}
 			Variant(const std::string& stringValue) : _type(Type::String), _stringValue(stringValue) {
 			}
+			// Without this overload string literals would silently become booleans
+			Variant(const char* stringValue) : _type(Type::String), _stringValue(stringValue) {
+			}
 
 			~Variant() {}
 			Variant(const Variant& variant) : _type(variant._type) {
-				if ( _type == Type::Integer ) {
-					_intValue = variant._intValue;
-				}
-				else if ( _type == Type::String ) {
+				if ( _type == Type::String ) {
 					_stringValue = variant._stringValue;
 				}
+				else {
+					_int64Value = variant._int64Value;
+				}
 			}
 
 			const Variant& operator=(const Variant& variant) {
 				_type = variant._type;
-				if ( _type == Type::Integer ) {
-					_intValue = variant._intValue;
-				}
-				else if ( _type == Type::String ) {
+				if ( _type == Type::String ) {
 					_stringValue = variant._stringValue;
 				}
+				else {
+					_int64Value = variant._int64Value;
+				}
 
 				return *this;
 			}
@@ -87,7 +102,98 @@ namespace hurricane {
 				_intValue = value;
 			}
 
-			std::string GetStringValue() const {
+			bool GetBooleanValue() const {
+				if ( _type == Type::Boolean ) {
+					return _boolValue;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetBooleanValue(bool value) {
+				_type = Type::Boolean;
+				_boolValue = value;
+			}
+
+			char GetCharacterValue() const {
+				if ( _type == Type::Character ) {
+					return _charValue;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetCharacterValue(char value) {
+				_type = Type::Character;
+				_charValue = value;
+			}
+
+			int8_t GetInt8Value() const {
+				if ( _type == Type::Int8 ) {
+					return _int8Value;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetInt8Value(int8_t value) {
+				_type = Type::Int8;
+				_int8Value = value;
+			}
+
+			int16_t GetInt16Value() const {
+				if ( _type == Type::Int16 ) {
+					return _int16Value;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetInt16Value(int16_t value) {
+				_type = Type::Int16;
+				_int16Value = value;
+			}
+
+			int64_t GetInt64Value() const {
+				if ( _type == Type::Int64 ) {
+					return _int64Value;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetInt64Value(int64_t value) {
+				_type = Type::Int64;
+				_int64Value = value;
+			}
+
+			float GetFloatValue() const {
+				if ( _type == Type::Float ) {
+					return _floatValue;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetFloatValue(float value) {
+				_type = Type::Float;
+				_floatValue = value;
+			}
+
+			double GetDoubleValue() const {
+				if ( _type == Type::Double ) {
+					return _doubleValue;
+				}
+
+				throw "Type mismatched";
+			}
+
+			void SetDoubleValue(double value) {
+				_type = Type::Double;
+				_doubleValue = value;
+			}
+
+			const std::string& GetStringValue() const {
 				if ( _type == Type::Invalid ) {
 					std::cerr << "Invalid";
 				}
@@ -104,12 +210,23 @@ namespace hurricane {
 				_stringValue = value;
 			}
 
+			void SetStringValue(const char* value, size_t size) {
+				_type = Type::String;
+				_stringValue.assign(value, size);
+			}
+
 		private:
 			Type _type;
+			// _int64Value is the widest member, copying it copies any of the scalar values
 			union {
 				int32_t _intValue;
 				bool _boolValue;
+				char _charValue;
+				int8_t _int8Value;
+				int16_t _int16Value;
+				int64_t _int64Value;
 				float _floatValue;
+				double _doubleValue;
 			};
 			std::string _stringValue;
 		};
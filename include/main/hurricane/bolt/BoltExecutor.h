@@ -21,6 +21,16 @@
 #include "hurricane/base/Executor.h"
 #include "hurricane/bolt/IBolt.h"
 #include "hurricane/base/Values.h"
+#include "hurricane/base/NetAddress.h"
+#include "hurricane/bolt/BoltMessage.h"
+#include "hurricane/message/MessagePool.h"
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <vector>
+#include <cstdint>
 
 namespace hurricane {
 
@@ -41,14 +51,54 @@ namespace hurricane {
         class BoltExecutor : public base::Executor<bolt::IBolt> {
         public:
             BoltExecutor();
+            ~BoltExecutor();
 
             void SetExecutorIndex(int executorIndex) {
                 _executorIndex = executorIndex;
             }
 
+            // Registers the executor as running in this process on the supervisor listening
+            // on address, so that co-located emitters hand their tuples to it directly.
+            // The executor index has to be set before.
+            void SetLocalAddress(const base::NetAddress& address);
+            static BoltExecutor* FindLocal(const base::NetAddress& address, int executorIndex);
+
             void SendData(const base::Values& values);
+            // The values are moved into a recycled message, pendingCount is decremented once
+            // the tuple has been executed
+            void SendData(base::Values&& values,
+                std::shared_ptr<std::atomic<int64_t>> pendingCount = nullptr);
             void OnData(hurricane::message::Message* message);
 
+            // The executor is overloaded once highWatermark tuples wait in its queue and
+            // stays so until the queue drained to lowWatermark. Upstream collectors stop
+            // sending to an overloaded executor.
+            void SetWatermarks(int64_t highWatermark, int64_t lowWatermark) {
+                _highWatermark = highWatermark;
+                _lowWatermark = lowWatermark < highWatermark ? lowWatermark : highWatermark;
+            }
+
+            bool IsOverloaded() const {
+                return _overloaded;
+            }
+
+            // Calls handler once on the executor thread when the overloaded executor drained to
+            // lowWatermark. Returns false without keeping the handler if it is not overloaded.
+            typedef std::function<void()> CapacityHandler;
+            bool OnCapacity(CapacityHandler handler);
+
+            // Tuples passed to IBolt::ExecuteBatch in one call at most, the queued tuples are
+            // executed as soon as the queue ran empty even if the batch is smaller.
+            // 1 executes every tuple on its own.
+            void SetExecuteBatchSize(int32_t executeBatchSize) {
+                _executeBatchSize = executeBatchSize > 0 ? executeBatchSize : 1;
+            }
+
+            static const int32_t DEFAULT_EXECUTE_BATCH_SIZE = 64;
+
+            static const int64_t DEFAULT_HIGH_WATERMARK = 8192;
+            static const int64_t DEFAULT_LOW_WATERMARK = 2048;
+
             void OnCreate() override;
             void OnStop() override;
 
@@ -57,11 +107,32 @@ namespace hurricane {
             }
             void RandomDestination(BoltOutputCollector* outputCollector);
             void GroupDestination(BoltOutputCollector* outputCollector, int fieldIndex);
+            // Asks the nimbus without waiting for the answer, the executor is not ready until it arrived
+            void RandomDestinationAsync(std::shared_ptr<BoltOutputCollector> outputCollector);
+
+        protected:
+            bool IsReady() override;
 
         private:
+            // Executes the tuples gathered by OnData and recycles their messages
+            void FlushBatch();
+
             topology::ITopology* _topology;
             message::SupervisorCommander* _commander;
             int _executorIndex;
+            std::shared_ptr<BoltOutputCollector> _outputCollector;
+            std::atomic<bool> _destinationPending;
+            message::MessagePool<BoltMessage> _messagePool;
+
+            int32_t _executeBatchSize;
+            std::vector<base::Values> _batchValues;
+            std::vector<BoltMessage*> _batchMessages;
+
+            int64_t _highWatermark;
+            int64_t _lowWatermark;
+            std::atomic<bool> _overloaded;
+            std::mutex _capacityMutex;
+            std::vector<CapacityHandler> _capacityHandlers;
         };
 
     }
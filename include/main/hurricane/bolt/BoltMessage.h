@@ -21,6 +21,11 @@
 #include "hurricane/message/Message.h"
 #include "hurricane/base/Values.h"
 
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
 namespace hurricane {
 
     namespace bolt {
@@ -29,14 +34,36 @@ namespace hurricane {
         public:
             struct MessageType {
                 enum {
-                    Data = 0x1000
+                    Data = 1
                 };
             };
 
+            BoltMessage() : hurricane::message::Message(MessageType::Data) {
+            }
+
             BoltMessage(const base::Values& values) : 
                 hurricane::message::Message(MessageType::Data), _values(values) {
             }
 
+            ~BoltMessage() {
+                Clear();
+            }
+
+            // pendingCount is decremented once the tuple has been executed
+            void SetPendingCount(std::shared_ptr<std::atomic<int64_t>> pendingCount) {
+                _pendingCount = std::move(pendingCount);
+            }
+
+            // Releases the tuple once it has been executed, so that the message can be reused
+            void Clear() {
+                if ( _pendingCount ) {
+                    (*_pendingCount) --;
+                    _pendingCount.reset();
+                }
+
+                _values.clear();
+            }
+
             const base::Values& GetValues() const {
                 return _values;
             }
@@ -45,8 +72,18 @@ namespace hurricane {
                 _values = values;
             }
 
+            void SetValues(base::Values&& values) {
+                _values = std::move(values);
+            }
+
+            // Moves the values out of the message, which still counts as pending until Clear
+            base::Values TakeValues() {
+                return std::move(_values);
+            }
+
         private:
             base::Values _values;
+            std::shared_ptr<std::atomic<int64_t>> _pendingCount;
         };
     }
 
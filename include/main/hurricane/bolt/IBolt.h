@@ -19,6 +19,9 @@
 #pragma once
 
 #include "hurricane/base/ITask.h"
+#include "hurricane/base/Values.h"
+
+#include <vector>
 
 namespace hurricane {
 
@@ -41,6 +44,14 @@ namespace hurricane {
             // 但又不同,消息源中的Execute会被主动反复执行,而消息处理器中这个Execute则属于被动执行-只有在其他的处理节点的数据到来时才会调用该成员函数,
             // 因此没有数据到来的时候,该函数处于阻塞状态
             virtual void Execute(const base::Values& values) = 0;
+            // Receives the tuples which arrived together, up to the execute batch size of the executor.
+            // Bolts writing to a sink or doing vectorizable work override it to pay the per call cost
+            // once per batch, the tuples are only valid during the call.
+            virtual void ExecuteBatch(const std::vector<base::Values>& tuples) {
+                for ( const base::Values& values : tuples ) {
+                    Execute(values);
+                }
+            }
 
 			// 该函数的作用和数据源中的CLone一样,用于复制任务对象
             virtual IBolt* Clone() const = 0;
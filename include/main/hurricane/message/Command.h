@@ -44,26 +44,39 @@ namespace hurricane {
 					StopBolt = 9,
 					RandomDestination = 10,
 					GroupDestination = 11,
+					Schema = 12,
+					BatchData = 252,
+					SchemaData = 253,
 					Response = 254,
 					Data = 255
 				};
 			};
 
-			Command() : _type(Command::Type::Invalid) {}
+			// New commands use the compact body format, receivers accept either format
+			Command() : _type(Command::Type::Invalid),
+				_version(hurricane::base::DataPackage::Version::Compact), _requestId(0) {}
 
 			Command(Command::Type::Values type, const hurricane::base::Variants& args) : 
-					_type(type), _args(args) {
+					_type(type), _args(args),
+					_version(hurricane::base::DataPackage::Version::Compact), _requestId(0) {
 			}
 
-			Command(const hurricane::base::DataPackage& dataPackage) {
-				const hurricane::base::Variants variants = dataPackage.GetVariants();
+			Command(const hurricane::base::DataPackage& dataPackage) :
+					_version(dataPackage.GetVersion()), _requestId(dataPackage.GetRequestId()) {
+				const hurricane::base::Variants& variants = dataPackage.GetVariants();
+				// The frame came from the network, one without a command type is an Invalid command
+				if ( variants.empty() || variants[0].GetType() != hurricane::base::Variant::Type::Integer ) {
+					_type = Command::Type::Invalid;
+					return;
+				}
+
 				_type = Command::Type::Values(variants[0].GetIntValue());
-				_args = variants;
-				_args.erase(_args.begin());
+				_args.assign(variants.begin() + 1, variants.end());
 			}
 
 			hurricane::base::DataPackage ToDataPackage() const {
-				hurricane::base::DataPackage dataPackage;
+				hurricane::base::DataPackage dataPackage(_version);
+				dataPackage.SetRequestId(_requestId);
 				dataPackage.AddVariant(int(_type));
 				for ( auto arg : _args ) {
 					dataPackage.AddVariant(arg);
@@ -88,6 +101,23 @@ namespace hurricane {
 				return _args[index];
 			}
 
+			int8_t GetVersion() const {
+				return _version;
+			}
+
+			void SetVersion(int8_t version) {
+				_version = version;
+			}
+
+			// A response has to carry the request id of the command it answers
+			int32_t GetRequestId() const {
+				return _requestId;
+			}
+
+			void SetRequestId(int32_t requestId) {
+				_requestId = requestId;
+			}
+
 			const hurricane::base::Variants& GetArgs() const {
 				return _args;
 			}
@@ -118,6 +148,8 @@ namespace hurricane {
 		private:
 			Command::Type::Values _type;
 			hurricane::base::Variants _args;
+			int8_t _version;
+			int32_t _requestId;
             std::shared_ptr<meshy::TcpConnection> _src;
 		};
 	}
@@ -23,7 +23,7 @@
 #include <functional>
 
 namespace meshy {
-    class TcpConnection;
+    class IStream;
 }
 
 namespace hurricane {
@@ -31,19 +31,28 @@ namespace hurricane {
 		class CommandDispatcher {
 		public:
 			typedef std::function<
-				void(hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src)
+				void(hurricane::base::Variants args, meshy::IStream* src)
 			> Handler;
 
+            CommandDispatcher() : _requestId(0) {}
+
             CommandDispatcher& OnCommand(Command::Type::Values type, Handler handler) {
                 _handlers[type] = handler;
 
                 return *this;
             }
 
-			void Dispatch(const Command& command);
+			// src is the connection the command arrived on, handlers send their responses through it
+			void Dispatch(const Command& command, meshy::IStream* src);
+
+			// The request id of the command being dispatched, handlers copy it into their response
+			int32_t GetRequestId() const {
+				return _requestId;
+			}
 
 		private:
 			std::map<Command::Type::Values, Handler> _handlers;
+			int32_t _requestId;
 		};
 	}
 }
\ No newline at end of file
@@ -31,6 +31,7 @@ namespace message {
 		// 该枚举类型定义了所有的消息类型,作为示例,我们定义了一个STOP消息
 		// 并为消息赋予了一个数字0,作为消息的唯一代码
 		struct Type {
+			// Types index the handler table of the message loop, they should stay small
 			enum {
 				Stop = 0
 			};
@@ -22,6 +22,14 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#ifndef WIN32
+#include <memory>
+#endif
 
 namespace hurricane {
 
@@ -30,12 +38,15 @@ namespace message {
 
     // 消息队列接口
     class MessageLoop {
+        struct Handler;
+
     public:
         // 消息的处理函数的类型定义 
         // 这里使用C++11的std::function类型作为回调函数的类型,因为该类型可以存储函数指针,也可以存储lambda表达式
         typedef std::function<void(Message*)> MessageHandler;
 
         MessageLoop();
+        ~MessageLoop();
         MessageLoop(const MessageLoop&) = delete;// 不可复制
         const MessageLoop& operator=(const MessageLoop&) = delete;
 
@@ -48,29 +59,149 @@ namespace message {
         */
         template <class ObjectType, class MethodType>
         void MessageMap(int messageType, ObjectType* self, MethodType method) {
-            MessageMap(messageType, std::bind(method, self, std::placeholders::_1));
+            MessageMap(messageType, [self, method](Message* message) {
+                (self->*method)(message);
+            });
         }
 
         void MessageMap(int messageType, MessageHandler handler) {
-            _messageHandlers.insert({ messageType, handler });
+            Handler& entry = GetHandler(messageType);
+            entry.invoke = &InvokeFunction;
+            entry.context = nullptr;
+            entry.function = handler;
+        }
+
+        // Calls the method through a plain function pointer, for handlers on the hot path
+        template <class ObjectType, void (ObjectType::*Method)(Message*)>
+        void MessageMap(int messageType, ObjectType* self) {
+            Handler& entry = GetHandler(messageType);
+            entry.invoke = &InvokeMethod<ObjectType, Method>;
+            entry.context = self;
+            entry.function = nullptr;
         }
 
         // 负责启动消息队列
+        // Handlers own the messages passed to them, the loop deletes the messages without a handler
         void Run();
         // 停止消息队列
         void Stop();
         // 负责向消息队列里投递消息
         void PostMessage(Message* message);
 
+        // Messages posted but not handled yet
+        int64_t GetPendingCount() const {
+            return _pendingCount;
+        }
+
+        // Called once the loop handled the messages it found queued, before it waits for more.
+        // Handlers which gather messages to handle them together flush them here.
+        void SetBatchEndHandler(std::function<void()> handler) {
+            _batchEndHandler = handler;
+        }
+
+#ifndef WIN32
+        // Handles up to maxMessages without blocking and returns the count of messages handled,
+        // for a loop which is run in slices by a scheduler instead of by Run. stopped is set once
+        // the stop message was handled. Only one thread may poll at a time.
+        int32_t Poll(int32_t maxMessages, bool* stopped);
+
+        // Called by PostMessage instead of waking up Run, it has to be set before the first
+        // message is posted
+        void SetWakeupHandler(std::function<void()> handler) {
+            _wakeupHandler = handler;
+        }
+
+        // Posting blocks while this many messages wait in the queue
+        static const uint64_t CAPACITY = 65536;
+        // Messages handled in a row before the queue is looked at again
+        static const int32_t BATCH_SIZE = 256;
+#endif
+
     private:
-        std::map<int, MessageHandler> _messageHandlers;
+        // Message types are small integers, so the handlers are found by indexing
+        struct Handler {
+            Handler() : invoke(nullptr), context(nullptr) {
+            }
+
+            void (*invoke)(const Handler& handler, Message* message);
+            void* context;
+            MessageHandler function;
+        };
+
+        template <class ObjectType, void (ObjectType::*Method)(Message*)>
+        static void InvokeMethod(const Handler& handler, Message* message) {
+            (static_cast<ObjectType*>(handler.context)->*Method)(message);
+        }
+
+        static void InvokeFunction(const Handler& handler, Message* message) {
+            handler.function(message);
+        }
+
+        Handler& GetHandler(int messageType) {
+            if ( messageType >= int(_messageHandlers.size()) ) {
+                _messageHandlers.resize(messageType + 1);
+            }
+
+            return _messageHandlers[messageType];
+        }
+
+        // Calls the handler of the message and returns false if there is none
+        bool Dispatch(int messageType, Message* message) {
+            if ( messageType < 0 || messageType >= int(_messageHandlers.size()) ||
+                !_messageHandlers[messageType].invoke ) {
+                return false;
+            }
+
+            const Handler& handler = _messageHandlers[messageType];
+            handler.invoke(handler, message);
+
+            return true;
+        }
+
+        std::vector<Handler> _messageHandlers;
+        std::function<void()> _batchEndHandler;
+#ifdef WIN32
         uint64_t _threadId;
+#else
+        // Bounded multi-producer single-consumer ring. A cell may be written once its sequence
+        // equals the position of the producer and read once it equals the position plus one.
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            Message* message;
+        };
+
+        // Returns true for the stop message
+        bool HandleMessage(Message* message);
+        bool TryPush(Message* message);
+        // Only called by the thread running the loop
+        bool TryPop(Message** message);
+        void WaitForMessage();
+
+        std::unique_ptr<Cell[]> _cells;
+        std::atomic<uint64_t> _pushPosition;
+        uint64_t _popPosition;
+        // Set by the consumer before it sleeps on the eventfd, producers only write to it then
+        std::atomic<bool> _waiting;
+        int _eventfd;
+        std::function<void()> _wakeupHandler;
+#endif
+        std::atomic<int64_t> _pendingCount;
     };
 
     // 管理消息循环
     // 该类的作用是解耦合,将所有的消息队列存放到一个映射表中,这样每一个名字就可以对应某一个消息队列
+    // Every registered loop also gets a compact handle, routing code should resolve the name
+    // once and post by handle, which neither hashes the name nor takes a lock
     class MessageLoopManager {
     public:
+        struct Handle {
+            enum {
+                Invalid = -1,
+                // Handles index a fixed table, so that it never moves under the posting threads
+                Max = 4096
+            };
+        };
+
         // GETINstance 将该类型单例化,这种使用函数局部的静态变量是C++中的常用技巧,用于解决初始化依赖问题
         static MessageLoopManager& GetInstance() {
             static MessageLoopManager manager;
@@ -82,22 +213,67 @@ namespace message {
         const MessageLoopManager& operator=(const MessageLoopManager&) = delete;
 
         // 注册消息队列,注册的时候只需要提供对列名和队列实例
-        void Register(const std::string& name, MessageLoop* loop) {
-            _messageLoops.insert({ name, std::shared_ptr<MessageLoop>(loop) });
+        // The manager owns the loop. Registering a name again points it to the new loop,
+        // the handles of the former one stay valid. Returns Handle::Invalid once the table is full.
+        int32_t Register(const std::string& name, MessageLoop* loop) {
+            std::unique_lock<std::mutex> locker(_registerMutex);
+
+            int32_t handle = int32_t(_ownedLoops.size());
+            _ownedLoops.push_back(std::shared_ptr<MessageLoop>(loop));
+            if ( handle >= Handle::Max ) {
+                return Handle::Invalid;
+            }
+
+            _messageLoops[handle].store(loop, std::memory_order_release);
+            _handles[name] = handle;
+
+            return handle;
+        }
+
+        // Slow path for tooling, resolves a name to its handle
+        int32_t GetHandle(const std::string& name) const {
+            std::unique_lock<std::mutex> locker(_registerMutex);
+
+            auto handlePair = _handles.find(name);
+            if ( handlePair == _handles.end() ) {
+                return Handle::Invalid;
+            }
+
+            return handlePair->second;
+        }
+
+        // Returns nullptr for an unknown handle, the loop lives as long as the manager
+        MessageLoop* GetMessageLoop(int32_t handle) const {
+            if ( handle < 0 || handle >= Handle::Max ) {
+                return nullptr;
+            }
+
+            return _messageLoops[handle].load(std::memory_order_acquire);
+        }
+
+        void PostMessage(int32_t handle, Message* message) {
+            MessageLoop* loop = GetMessageLoop(handle);
+            if ( loop ) {
+                loop->PostMessage(message);
+            }
         }
         
         // 传递消息,只需要使用消息队列的名称就可以将消息投递到对应的消息队列了
         void PostMessage(const std::string& name, Message* message) {
-            auto messageLoopPair = _messageLoops.find(name);
-            if ( messageLoopPair != _messageLoops.end() ) {
-                messageLoopPair->second->PostMessage(message);
-            }
+            PostMessage(GetHandle(name), message);
         }
 
     private:
-        MessageLoopManager() {}
+        MessageLoopManager() : _messageLoops(new std::atomic<MessageLoop*>[Handle::Max]) {
+            for ( int32_t handle = 0; handle < Handle::Max; handle ++ ) {
+                _messageLoops[handle].store(nullptr, std::memory_order_relaxed);
+            }
+        }
 
-        std::map<std::string, std::shared_ptr<MessageLoop>> _messageLoops;
+        std::unique_ptr<std::atomic<MessageLoop*>[]> _messageLoops;
+        std::vector<std::shared_ptr<MessageLoop>> _ownedLoops;
+        std::map<std::string, int32_t> _handles;
+        mutable std::mutex _registerMutex;
     };
 }
 
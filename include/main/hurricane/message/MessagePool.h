@@ -0,0 +1,130 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace hurricane {
+
+namespace message {
+    // Recycles the messages of one type so that posting a message does not allocate.
+    // Any thread may acquire and release messages, the free messages are kept in a bounded
+    // lock-free ring and the ones which do not fit are deleted.
+    template <class MessageType>
+    class MessagePool {
+    public:
+        MessagePool() : _cells(new Cell[CAPACITY]), _pushPosition(0), _popPosition(0) {
+            for ( uint64_t position = 0; position < CAPACITY; position ++ ) {
+                _cells[position].sequence.store(position, std::memory_order_relaxed);
+            }
+        }
+
+        MessagePool(const MessagePool&) = delete;
+        const MessagePool& operator=(const MessagePool&) = delete;
+
+        ~MessagePool() {
+            MessageType* message;
+            while ( TryPop(&message) ) {
+                delete message;
+            }
+        }
+
+        MessageType* Acquire() {
+            MessageType* message;
+            if ( TryPop(&message) ) {
+                return message;
+            }
+
+            return new MessageType;
+        }
+
+        void Release(MessageType* message) {
+            if ( !TryPush(message) ) {
+                delete message;
+            }
+        }
+
+        static const uint64_t CAPACITY = 4096;
+
+    private:
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            MessageType* message;
+        };
+
+        bool TryPush(MessageType* message) {
+            uint64_t position = _pushPosition.load(std::memory_order_relaxed);
+
+            while ( true ) {
+                Cell& cell = _cells[position & (CAPACITY - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+                if ( sequence == position ) {
+                    if ( _pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) ) {
+                        cell.message = message;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+
+                        return true;
+                    }
+                }
+                else if ( sequence < position ) {
+                    return false;
+                }
+                else {
+                    position = _pushPosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool TryPop(MessageType** message) {
+            uint64_t position = _popPosition.load(std::memory_order_relaxed);
+
+            while ( true ) {
+                Cell& cell = _cells[position & (CAPACITY - 1)];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+                if ( sequence == position + 1 ) {
+                    if ( _popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) ) {
+                        *message = cell.message;
+                        cell.sequence.store(position + CAPACITY, std::memory_order_release);
+
+                        return true;
+                    }
+                }
+                else if ( sequence < position + 1 ) {
+                    return false;
+                }
+                else {
+                    position = _popPosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::unique_ptr<Cell[]> _cells;
+        std::atomic<uint64_t> _pushPosition;
+        std::atomic<uint64_t> _popPosition;
+    };
+
+    template <class MessageType>
+    const uint64_t MessagePool<MessageType>::CAPACITY;
+}
+
+}
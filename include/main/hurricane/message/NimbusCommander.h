@@ -20,11 +20,17 @@
 
 #include "hurricane/base/NetAddress.h"
 #include "hurricane/base/NetConnector.h"
+#include "hurricane/message/Command.h"
+
+#include <functional>
 
 namespace hurricane {
 	namespace message {
 		class NimbusCommander {
 		public:
+			// Called on the io loop thread
+			typedef std::function<void(const Command& response)> ResponseCallback;
+
 			NimbusCommander(const hurricane::base::NetAddress& supervisorAddress) :
 				_supervisorAddress(supervisorAddress) {
 			}
@@ -38,8 +44,12 @@ namespace hurricane {
 
 			void StartSpout(const std::string& spoutName, int executorIndex);
 			void StartBolt(const std::string& boltName, int executorIndex);
+			void StartSpoutAsync(const std::string& spoutName, int executorIndex, ResponseCallback callback);
+			void StartBoltAsync(const std::string& boltName, int executorIndex, ResponseCallback callback);
 
 		private:
+			void SendCommandAsync(const Command& command, ResponseCallback callback);
+
 			hurricane::base::NetAddress _supervisorAddress;
 			std::shared_ptr<NetConnector> _connector;
 		};
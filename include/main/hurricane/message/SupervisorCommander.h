@@ -21,41 +21,184 @@
 #include "hurricane/base/NetAddress.h"
 #include "hurricane/base/NetConnector.h"
 #include "hurricane/base/Values.h"
+#include "hurricane/base/ByteArray.h"
+#include "hurricane/base/Fields.h"
+#include "hurricane/base/TupleSchema.h"
+#include "hurricane/message/Command.h"
 #include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace hurricane {
 	namespace message {
 		class SupervisorCommander {
 		public:
+			// The callbacks of the asynchronous requests are called on the io loop thread,
+			// a request which failed passes an Invalid command
+			typedef std::function<void(const Command& response)> ResponseCallback;
+			// destIndex is -1 if the nimbus did not answer
+			typedef std::function<void(const std::string& host, int port, int destIndex)> DestinationCallback;
+
 			SupervisorCommander(const hurricane::base::NetAddress& nimbusAddress,
 				const std::string& supervisorName) :
-				_nimbusAddress(nimbusAddress), _supervisorName(supervisorName) {
+				_nimbusAddress(nimbusAddress), _supervisorName(supervisorName),
+				_schemaDeclared(false), _ackWindowTuples(0), _ackWindowBytes(0),
+				_retransmitOnReconnect(false), _noDelay(false),
+				_ackTimeout(DEFAULT_ACK_TIMEOUT_MILLISECONDS), _connectionGeneration(0), _connectionFailed(false),
+				_sentSequence(0), _unackedTuples(0), _unackedBytes(0), _unrequestedTuples(0), _unrequestedBytes(0) {
 			}
 
 			void Connect() {
 				if ( !_connector.get() ) {
 					_connector = std::make_shared<NetConnector>(_nimbusAddress);
+					_connector->SetNoDelay(_noDelay);
 					_connector->Connect();
 				}
 			}
 
 			void Join();
 			void Alive();
+			void JoinAsync(ResponseCallback callback);
+			void AliveAsync(ResponseCallback callback);
 			void SendTuple(int taskIndex, const base::Values& values);
-			void RandomDestination(const std::string srcType, int32_t srcIndex,
+			// Sends all tuples to one task in a single frame, the supervisor name and
+			// the task index are only carried once
+			void SendTuples(int taskIndex, const std::vector<base::Values>& tuples);
+			// Enables schema encoding for SendTuple. The schema is declared on the connection
+			// with the first tuple, afterwards matching tuples are sent as bare values.
+			void SetSchemaFields(const base::Fields& fields) {
+				_schemaFields = fields;
+			}
+
+			// Makes SendTuple and SendTuples one-way. Only one frame in every half window asks for
+			// a response, which acknowledges all frames sent before it. Sending blocks while
+			// windowTuples tuples or windowBytes bytes are unacknowledged, 0 disables a limit.
+			// Senders which must not block check IsAckWindowOpen first.
+			void SetAckWindow(int32_t windowTuples, int32_t windowBytes) {
+				_ackWindowTuples = windowTuples;
+				_ackWindowBytes = windowBytes;
+			}
+
+			// Keeps the unacknowledged frames so that Reconnect sends them again
+			void SetRetransmitOnReconnect(bool retransmitOnReconnect) {
+				_retransmitOnReconnect = retransmitOnReconnect;
+			}
+
+			// A sender waiting for the window longer than ackTimeout reconnects, as it does when the
+			// connection closed. If the window does not open on the new connection either, its
+			// frames are given up.
+			void SetAckTimeout(std::chrono::milliseconds ackTimeout) {
+				_ackTimeout = ackTimeout;
+			}
+
+			// Whether a tuple frame is sent without waiting for acknowledgements. A window which
+			// stayed full for ackTimeout counts as open, the next frame reconnects then.
+			bool IsAckWindowOpen();
+
+			// The connection closed, Reconnect replaces it
+			bool IsConnectionClosed() const {
+				return _connector && _connector->IsClosed();
+			}
+
+			// Sends small frames without waiting for the acknowledgement of the previous ones,
+			// for latency bound flows. Throughput bound flows keep the kernel coalescing.
+			void SetNoDelay(bool noDelay) {
+				_noDelay = noDelay;
+				if ( _connector ) {
+					_connector->SetNoDelay(noDelay);
+				}
+			}
+
+			// Tuples sent in frames the peer did not acknowledge yet, only tracked with an ack window
+			int32_t GetUnackedTupleCount() {
+				std::unique_lock<std::mutex> locker(_ackMutex);
+				return _unackedTuples;
+			}
+
+			// Bytes which wait to be written to the connection
+			size_t GetSendQueueSize() const {
+				return _connector ? _connector->GetSendQueueSize() : 0;
+			}
+
+			// Replaces the connection, declares the schema again and retransmits the
+			// unacknowledged frames if enabled. Otherwise they are given up.
+			void Reconnect();
+
+			static const int32_t DEFAULT_ACK_WINDOW_TUPLES = 4096;
+			static const int32_t DEFAULT_ACK_WINDOW_BYTES = 4 * 1024 * 1024;
+			static const int32_t DEFAULT_ACK_TIMEOUT_MILLISECONDS = 30000;
+
+			// Return false if the nimbus did not answer, the destination is left unchanged then
+			bool RandomDestination(const std::string srcType, int32_t srcIndex,
 				std::string * host, int * port, int* destIndex);
-			void GroupDestination(const std::string srcType, int srcIndex,
+			bool GroupDestination(const std::string srcType, int srcIndex,
 				std::string * host, int * port, int* destIndex,
 				int fieldIndex);
+			void RandomDestinationAsync(const std::string& srcType, int32_t srcIndex,
+				DestinationCallback callback);
+			void GroupDestinationAsync(const std::string& srcType, int srcIndex, int fieldIndex,
+				DestinationCallback callback);
 			const std::string GetSupervisorName() const {
 				return _supervisorName;
 			}
 
 		private:
+			bool UseSchema(const base::Values& values);
+			void DeclareSchema(const base::Values& values);
+			void SendSchemaTuples(int taskIndex, const base::Values* tuples, int32_t tupleCount);
+			void SendMessageBuffer();
+			void SendSchemaDeclaration();
+			void SendTupleFrame(int32_t tupleCount);
+			void Acknowledge(int64_t sequence);
+			// Called when an acknowledgement request of the connection generation failed
+			void FailAcknowledgements(int64_t generation);
+			bool IsAckWindowFull() const;
+			// Called with _ackMutex held, returns false if the acknowledgements are not coming
+			bool WaitForAckWindow(std::unique_lock<std::mutex>& locker);
+			// Called with _ackMutex held
+			void DropUnackedFrames();
+			void SendCommandAsync(const Command& command, ResponseCallback callback);
+
 			hurricane::base::NetAddress _nimbusAddress;
 			std::string _supervisorName;
 			std::shared_ptr<NetConnector> _connector;
             int32_t _taskIndex;
+			// Reused by every request so that sending a command does not allocate a new frame
+			hurricane::base::ByteArray _messageBuffer;
+			hurricane::base::Fields _schemaFields;
+			hurricane::base::TupleSchema _schema;
+			bool _schemaDeclared;
+
+			struct UnackedFrame {
+				int64_t sequence;
+				int32_t tupleCount;
+				int32_t size;
+				std::chrono::steady_clock::time_point sentTime;
+				// Only kept for retransmission
+				hurricane::base::ByteArray frame;
+			};
+
+			int32_t _ackWindowTuples;
+			int32_t _ackWindowBytes;
+			bool _retransmitOnReconnect;
+			bool _noDelay;
+			std::chrono::milliseconds _ackTimeout;
+			std::mutex _ackMutex;
+			std::condition_variable _ackCondition;
+			std::deque<UnackedFrame> _unackedFrames;
+			// Failures of the requests sent on a replaced connection are ignored
+			int64_t _connectionGeneration;
+			bool _connectionFailed;
+			int64_t _sentSequence;
+			int32_t _unackedTuples;
+			int64_t _unackedBytes;
+			// Sent after the last frame which asked for an acknowledgement
+			int32_t _unrequestedTuples;
+			int64_t _unrequestedBytes;
 		};
 	}
 }
@@ -22,6 +22,10 @@
 #include "hurricane/spout/ISpout.h"
 
 #include <iostream>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace hurricane {
     
@@ -40,7 +44,8 @@ namespace hurricane {
         class SpoutExecutor : public base::Executor<spout::ISpout> {
         public:
             SpoutExecutor() : 
-                base::Executor<spout::ISpout>(), _needToStop(false) {
+                base::Executor<spout::ISpout>(), _needToStop(false), _destinationPending(false),
+                _maxPending(DEFAULT_MAX_PENDING) {
             }
 
             void StopTask() override;
@@ -51,15 +56,39 @@ namespace hurricane {
                 _executorIndex = executorIndex;
             }
 
+            // Execute is not called while maxPending emitted tuples are not acknowledged
+            // by their destination, 0 disables the limit
+            void SetMaxPending(int64_t maxPending) {
+                _maxPending = maxPending;
+            }
+
+            static const int64_t DEFAULT_MAX_PENDING = 0;
+            // Calls to Execute in one slice of a scheduled spout
+            static const int32_t EXECUTE_BATCH_SIZE = 64;
+
             void SetCommander(message::SupervisorCommander* commander);
             void RandomDestination(SpoutOutputCollector* outputCollector);
             void GroupDestination(SpoutOutputCollector* outputCollector, int fieldIndex);
+            // Asks the nimbus without waiting for the answer, the executor is not ready until it arrived
+            void RandomDestinationAsync(std::shared_ptr<SpoutOutputCollector> outputCollector);
+
+        protected:
+            bool IsReady() override;
+            int32_t OnIdle(std::chrono::microseconds* delay) override;
 
         private:
+            // Calls Execute unless the spout is throttled, returns whether it emitted a tuple
+            bool ExecuteOnce();
+            // Tuples acknowledged in one window, never more than may be pending
+            int32_t GetAckWindowTuples() const;
+
             topology::ITopology* _topology;
-            bool _needToStop;
+            std::atomic<bool> _needToStop;
             message::SupervisorCommander* _commander;
             int _executorIndex;
+            std::shared_ptr<SpoutOutputCollector> _outputCollector;
+            std::atomic<bool> _destinationPending;
+            int64_t _maxPending;
         };
 
     }
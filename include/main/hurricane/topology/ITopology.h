@@ -19,6 +19,7 @@
 #pragma once
 
 #include "hurricane/base/Values.h"
+#include "hurricane/base/Placement.h"
 
 #include <string>
 #include <memory>
@@ -50,6 +51,16 @@ public:
 	virtual const std::map<std::string, std::vector<std::string>>& GetNetwork() const = 0;
 
     virtual void Start() = 0;
+
+    // A base::Placement::Policy, how the supervisors place the threads of the topology
+    virtual int32_t GetPlacementPolicy() const {
+        return base::Placement::Policy::None;
+    }
+
+    // Tuples an executor of the spout may have emitted without their acknowledgement, 0 for no limit
+    virtual int64_t GetMaxPending(const std::string&) const {
+        return 0;
+    }
 };
 
 }
@@ -45,6 +45,21 @@ public:
 	virtual const std::map<std::string, std::shared_ptr<bolt::IBolt>>& GetBolts() const override;
 	virtual const std::map<std::string, std::vector<std::string>>& GetNetwork() const override;
 
+    void SetPlacementPolicy(int32_t placementPolicy) {
+        _placementPolicy = placementPolicy;
+    }
+
+    int32_t GetPlacementPolicy() const override {
+        return _placementPolicy;
+    }
+
+    // Indexed by spout name, the spouts which are missing have no limit
+    void SetMaxPending(std::map<std::string, int64_t> maxPending) {
+        _maxPending = maxPending;
+    }
+
+    int64_t GetMaxPending(const std::string& spoutName) const override;
+
     std::map<std::string, std::shared_ptr<spout::ISpout>>& GetSpouts();
     std::map<std::string, std::shared_ptr<bolt::IBolt>>& GetBolts();
     std::map<std::string, std::vector<std::string>>& GetNetwork();
@@ -58,6 +73,8 @@ private:
     std::map<std::string, std::shared_ptr<spout::ISpout>> _spouts;
     std::map<std::string, std::shared_ptr<bolt::IBolt>> _bolts;
     std::map<std::string, std::vector<std::string>> _network;
+    int32_t _placementPolicy;
+    std::map<std::string, int64_t> _maxPending;
 };
 
 }
@@ -30,8 +30,16 @@ namespace topology {
 
 class TopologyBuilder {
 public:
+    TopologyBuilder() : _placementPolicy(base::Placement::Policy::None) {
+    }
+
     void SetSpout(const std::string& name, spout::ISpout* spout);
     void SetBolt(const std::string& name, bolt::IBolt* bolt, const std::string& prev);
+    // A base::Placement::Policy, threads are not placed by default
+    void SetPlacementPolicy(int32_t placementPolicy);
+    // The executors of the spout stop calling Execute while maxPending of their tuples are not
+    // acknowledged, 0 disables the limit which is the default
+    void SetMaxPending(const std::string& spoutName, int64_t maxPending);
 
 	SimpleTopology* Build();
 
@@ -39,6 +47,8 @@ private:
     std::map<std::string, std::shared_ptr<spout::ISpout>> _spouts;
     std::map<std::string, std::shared_ptr<bolt::IBolt>> _bolts;
     std::map<std::string, std::vector<std::string>> _network;
+    int32_t _placementPolicy;
+    std::map<std::string, int64_t> _maxPending;
 };
 
 }
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 
 #include "hurricane/base/NetAddress.h"
 #include "hurricane/base/ByteArray.h"
@@ -215,7 +216,7 @@ int main() {
     // 该lambda表达式包含两个参数,一个是命令中附带的参数合集,属于variants类型,一个是src,表示命令源的tcp连接对象
     dispatcher
         .OnCommand(Command::Type::Join,
-            [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         // 获取第一个参数,并将其转换为字符串,该参数是想要加入集群的Manager的主机名
         std::string supervisorName = args[0].GetStringValue();
 
@@ -232,6 +233,7 @@ int main() {
         Command command(Command::Type::Response, {
             std::string("nimbus")
         });
+        command.SetRequestId(dispatcher.GetRequestId());
 
         // 使用toDataPackage成员函数,将命令转换成用于序列化的数据包对象
         // 接着使用Serialize成员函数,将数据包的数据序列化成字节流,并将字节数组保存在commandBytes数组对象中
@@ -244,19 +246,20 @@ int main() {
         }
     })
         .OnCommand(Command::Type::Alive,
-            [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         std::string supervisorName = args[0].GetStringValue();
         supervisors[supervisorName].Alive();
 
         Command command(Command::Type::Response, {
             std::string("nimbus")
         });
+        command.SetRequestId(dispatcher.GetRequestId());
 
         ByteArray commandBytes = command.ToDataPackage().Serialize();
         src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
     })
         .OnCommand(Command::Type::RandomDestination,
-            [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         std::string supervisorName = args[0].GetStringValue();
         std::string srcType = args[1].GetStringValue();
         int srcIndex = args[2].GetIntValue();
@@ -305,6 +308,7 @@ int main() {
                 supervisors[hostName].GetAddress().GetPort(),
                 destIndex
             });
+            command.SetRequestId(dispatcher.GetRequestId());
 
             ByteArray commandBytes = command.ToDataPackage().Serialize();
             src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
@@ -352,13 +356,14 @@ int main() {
                 supervisors[hostName].GetAddress().GetPort(),
                 destIndex
             });
+            command.SetRequestId(dispatcher.GetRequestId());
 
             ByteArray commandBytes = command.ToDataPackage().Serialize();
             src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
         }
     })
     .OnCommand(Command::Type::GroupDestination,
-        [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+        [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         std::string supervisorName = args[0].GetStringValue();
         std::string srcType = args[1].GetStringValue();
         int srcIndex = args[2].GetIntValue();
@@ -378,6 +383,7 @@ int main() {
                 result.first.GetAddress().GetPort(),
                 result.second
             });
+            command.SetRequestId(dispatcher.GetRequestId());
 
             ByteArray commandBytes = command.ToDataPackage().Serialize();
             src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
@@ -394,6 +400,7 @@ int main() {
                 result.first.GetAddress().GetPort(),
                 result.second
             });
+            command.SetRequestId(dispatcher.GetRequestId());
 
             ByteArray commandBytes = command.ToDataPackage().Serialize();
             src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
@@ -444,6 +451,7 @@ int main() {
                 supervisors[hostName].GetAddress().GetPort(),
                 destIndex
             });
+            command.SetRequestId(dispatcher.GetRequestId());
 
             ByteArray commandBytes = command.ToDataPackage().Serialize();
             src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
@@ -452,20 +460,21 @@ int main() {
     
     // 这里是业务层以下的部分,NETlistener消息处理部分
     // 该网络通信的data事件,回调函数是一个Lambda表达式,该表达式1个参数是客户端的Tcp连接,第2个参数是数据缓冲区首地址,第三个参数是数据长度
+    // 网络层有多个事件循环线程,命令分发需要串行化
+    std::mutex dispatcherMutex;
     netListener.OnData([&](meshy::TcpStream* connection, 
             const char* buffer, int32_t size) -> void {
-        // 利用收到的数据构建一个信息的字节数组对象,保存在receiveData中.
-        ByteArray receivedData(buffer, size);
 		// 定义一个数据包
         DataPackage receivedPackage;
 		// 将收到的二进制数据反序列化，这样就可以本地内存的数据结构
-        receivedPackage.Deserialize(receivedData);
+        receivedPackage.Deserialize(buffer, size);
         
 		// 创建新命令，命令的内容是刚才的数据包
         Command command(receivedPackage);
 
 		// 分发命令
-        dispatcher.Dispatch(command);
+        std::lock_guard<std::mutex> dispatcherLocker(dispatcherMutex);
+        dispatcher.Dispatch(command, connection);
     });
 
     netListener.StartListen();
@@ -22,29 +22,48 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <memory>
 
 #include "hurricane/base/NetAddress.h"
 #include "hurricane/base/ByteArray.h"
 #include "hurricane/base/DataPackage.h"
 #include "hurricane/base/Value.h"
 #include "hurricane/base/Variant.h"
+#include "hurricane/base/TupleSchema.h"
 #include "hurricane/message/SupervisorCommander.h"
 #include "hurricane/message/CommandDispatcher.h"
 #include "hurricane/topology/ITopology.h"
 #include "hurricane/base/NetListener.h"
+#include "hurricane/bolt/BoltExecutor.h"
+#include "hurricane/spout/SpoutExecutor.h"
+#include "hurricane/base/Placement.h"
+#include "hurricane/base/TaskScheduler.h"
+
+#ifdef OS_LINUX
+#include "IoLoop.h"
+#endif
 
 using hurricane::base::NetAddress;
 using hurricane::base::ByteArray;
+using hurricane::base::ByteArrayView;
+using hurricane::base::ByteArrayReader;
 using hurricane::base::DataPackage;
 using hurricane::base::Variant;
 using hurricane::base::Variants;
 using hurricane::base::Value;
 using hurricane::base::Values;
+using hurricane::base::TupleSchema;
+using hurricane::base::Placement;
+using hurricane::base::TaskScheduler;
 using hurricane::message::Command;
 using hurricane::message::CommandDispatcher;
 using hurricane::message::SupervisorCommander;
+using hurricane::bolt::BoltExecutor;
+using hurricane::spout::SpoutExecutor;
 using hurricane::topology::ITopology;
 
 hurricane::topology::ITopology* GetTopology();
@@ -53,6 +72,9 @@ const NetAddress NIMBUS_ADDRESS{ "127.0.0.1", 6000 };
 const std::map<std::string, NetAddress> SUPERVISOR_ADDRESSES{
     { "s1",{ "127.0.0.1", 7001 } }
 };
+// The executors of these supervisors share a pool of workers of the given size, 0 starts one
+// worker per core, e.g. { "s1", 0 }. The executors of the other supervisors run on threads of their own.
+const std::map<std::string, int32_t> SUPERVISOR_SCHEDULER_WORKERS;
 
 void AliveThreadMain(const std::string& name) {
     SupervisorCommander commander(NIMBUS_ADDRESS, name);
@@ -76,6 +98,26 @@ int main(int argc, char** argv) {
 
 	// ⲿļװTopology
     ITopology* topology = GetTopology();
+    if ( !topology ) {
+        std::cerr << "No topology loaded" << std::endl;
+        exit(-1);
+    }
+
+    // The tasks exchanging tuples are kept on one node and the network loops are spread
+    // across the nodes, as far as the topology asks for it
+    std::shared_ptr<Placement> placement = std::make_shared<Placement>(topology->GetPlacementPolicy());
+    placement->Plan(topology->GetNetwork());
+#ifdef OS_LINUX
+    meshy::IoLoop::SetThreadStartHandler([placement](int32_t loopIndex) {
+        placement->PinThread(loopIndex);
+    });
+#endif
+
+    std::unique_ptr<TaskScheduler> scheduler;
+    auto schedulerWorkers = SUPERVISOR_SCHEDULER_WORKERS.find(supervisorName);
+    if ( schedulerWorkers != SUPERVISOR_SCHEDULER_WORKERS.end() ) {
+        scheduler.reset(new TaskScheduler(schedulerWorkers->second, placement.get()));
+    }
 
 	// һµ̣߳
     std::thread aliveThread(AliveThreadMain, supervisorName);
@@ -85,10 +127,11 @@ int main(int argc, char** argv) {
     CommandDispatcher dispatcher;
     dispatcher
         .OnCommand(Command::Type::StartBolt,
-            [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         Command command(Command::Type::Response, {
             std::string(supervisorName)
         });
+        command.SetRequestId(dispatcher.GetRequestId());
 
         std::string taskName = args[0].GetStringValue();
         int executorIndex = args[1].GetIntValue();
@@ -97,14 +140,42 @@ int main(int argc, char** argv) {
         std::cout << "Bolt name: " << taskName << std::endl;
         std::cout << "Executor index: " << executorIndex << std::endl;
 
+        auto bolt = topology->GetBolts().find(taskName);
+        if ( bolt != topology->GetBolts().end() ) {
+            // Executors run until the supervisor exits. They are built on the node of their task,
+            // so that their queues and the task are allocated in its memory.
+            BoltExecutor* executor = nullptr;
+            hurricane::bolt::IBolt* task = nullptr;
+            placement->RunOnNode(placement->GetNode(taskName), [&]() {
+                executor = new BoltExecutor;
+                task = bolt->second->Clone();
+            });
+            executor->SetExecutorIndex(executorIndex);
+            executor->SetCommander(new SupervisorCommander(NIMBUS_ADDRESS, supervisorName));
+            executor->SetPlacement(placement.get());
+            if ( scheduler ) {
+                executor->StartTask(taskName, task, scheduler.get());
+            }
+            else {
+                executor->StartTask(taskName, task);
+            }
+            // Emitters on this supervisor hand their tuples to the executor directly. It is only
+            // published once started, a scheduled executor is woken up through its scheduler then.
+            executor->SetLocalAddress(SUPERVISOR_ADDRESSES.at(supervisorName));
+        }
+        else {
+            std::cerr << "Unknown bolt " << taskName << std::endl;
+        }
+
         ByteArray commandBytes = command.ToDataPackage().Serialize();
         src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
     })
         .OnCommand(Command::Type::StartSpout,
-            [&](hurricane::base::Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         Command command(Command::Type::Response, {
             std::string(supervisorName)
         });
+        command.SetRequestId(dispatcher.GetRequestId());
 
         std::string taskName = args[0].GetStringValue();
         int executorIndex = args[1].GetIntValue();
@@ -113,40 +184,247 @@ int main(int argc, char** argv) {
         std::cout << "Spout name: " << taskName  << std::endl;
         std::cout << "Executor index: " << executorIndex  << std::endl;
 
+        auto spout = topology->GetSpouts().find(taskName);
+        if ( spout != topology->GetSpouts().end() ) {
+            SpoutExecutor* executor = nullptr;
+            hurricane::spout::ISpout* task = nullptr;
+            placement->RunOnNode(placement->GetNode(taskName), [&]() {
+                executor = new SpoutExecutor;
+                task = spout->second->Clone();
+            });
+            executor->SetExecutorIndex(executorIndex);
+            executor->SetCommander(new SupervisorCommander(NIMBUS_ADDRESS, supervisorName));
+            executor->SetPlacement(placement.get());
+            executor->SetMaxPending(topology->GetMaxPending(taskName));
+            if ( scheduler ) {
+                executor->StartTask(taskName, task, scheduler.get());
+            }
+            else {
+                executor->StartTask(taskName, task);
+            }
+        }
+        else {
+            std::cerr << "Unknown spout " << taskName << std::endl;
+        }
+
         ByteArray commandBytes = command.ToDataPackage().Serialize();
         src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
-    })
-        .OnCommand(Command::Type::Data,
-            [&](Variants args, std::shared_ptr<meshy::TcpConnection> src) -> void {
-        //TODO: Dispatch tuple
-        std::string srcSupervisorName = args[0].GetStringValue();
-        args.erase(args.begin());
-        int32_t taskIndex = args[0].GetIntValue();
-        args.erase(args.begin());
-
-        Values values;
-        for ( auto& arg : args ) {
-            values.push_back(Value::FromVariant(arg));
+    });
+
+
+    // Tuple schemas declared by the peers, one per open connection
+    std::map<meshy::TcpStream*, TupleSchema> connectionSchemas;
+    // Connections are served by several network loops at the same time
+    std::mutex connectionSchemasMutex;
+    std::mutex dispatcherMutex;
+
+    // Connections whose reads are paused until the executor they feed drained its queue
+    std::set<meshy::TcpStream*> pausedConnections;
+    std::mutex pausedConnectionsMutex;
+
+    // The network loops must not block, they also deliver the acknowledgements of the local
+    // executors. An overloaded executor stops the connection from being read instead, so that
+    // its senders are slowed down through their socket buffers.
+    auto pauseWhileOverloaded = [&](meshy::TcpStream* connection, BoltExecutor* executor) {
+        if ( !executor || !executor->IsOverloaded() ) {
+            return;
         }
 
-        Command command(Command::Type::Response, {
+        std::lock_guard<std::mutex> pausedLocker(pausedConnectionsMutex);
+        if ( pausedConnections.count(connection) ) {
+            return;
+        }
+
+        // The lock keeps the handler waiting until the connection has been paused
+        bool overloaded = executor->OnCapacity([&pausedConnections, &pausedConnectionsMutex, connection]() {
+            std::lock_guard<std::mutex> pausedLocker(pausedConnectionsMutex);
+            // Already erased if the connection closed in the meantime
+            if ( pausedConnections.erase(connection) ) {
+                connection->ResumeReceiving();
+            }
+        });
+
+        if ( overloaded ) {
+            connection->PauseReceiving();
+            pausedConnections.insert(connection);
+        }
+    };
+
+    // Tuples are acknowledged on the connection they arrived on, one-way tuples carry no
+    // request id and are acknowledged by the response to a later frame
+    auto sendResponse = [&supervisorName](meshy::TcpStream* connection, int32_t requestId) {
+        if ( !requestId ) {
+            return;
+        }
+
+        Command response(Command::Type::Response, {
             std::string(supervisorName)
         });
+        response.SetRequestId(requestId);
 
-        ByteArray commandBytes = command.ToDataPackage().Serialize();
-        src->Send(*(reinterpret_cast<meshy::ByteArray*>(&commandBytes)));
-    });
+        ByteArray responseBytes = response.ToDataPackage().Serialize();
+        connection->Send(*(reinterpret_cast<meshy::ByteArray*>(&responseBytes)));
+    };
 
+    // The frames come from the network, a variant is checked before it is read
+    auto isInteger = [](const Variants& variants, size_t index) {
+        return index < variants.size() && variants[index].GetType() == Variant::Type::Integer;
+    };
+    auto closeConnection = [&netListener](meshy::TcpStream* connection, const char* reason) {
+        std::cerr << reason << ", closing the connection" << std::endl;
+        netListener.Close(connection);
+    };
 
     netListener.OnData([&](meshy::TcpStream* connection,
         const char* buffer, int32_t size) -> void {
-        ByteArray receivedData(buffer, size);
         DataPackage receivedPackage;
-        receivedPackage.Deserialize(receivedData);
+        ByteArrayView body = receivedPackage.Deserialize(buffer, size, 1);
+        if ( !isInteger(receivedPackage.GetVariants(), 0) ) {
+            closeConnection(connection, "Frame without a command type");
+            return;
+        }
+
+        // Schema encoded tuples only tag the command type, the task index and the tuple count,
+        // the values are decoded with the schema declared on this connection
+        if ( receivedPackage.GetVariants()[0].GetIntValue() == Command::Type::SchemaData ) {
+            body = receivedPackage.DeserializeVariants(body, 2);
+            if ( !isInteger(receivedPackage.GetVariants(), 1) || !isInteger(receivedPackage.GetVariants(), 2) ) {
+                closeConnection(connection, "Schema encoded tuples without task index or tuple count");
+                return;
+            }
 
+            int32_t taskIndex = receivedPackage.GetVariants()[1].GetIntValue();
+            int32_t tupleCount = receivedPackage.GetVariants()[2].GetIntValue();
+
+            // Only the network loop of the connection replaces or erases its schema
+            std::unique_lock<std::mutex> schemaLocker(connectionSchemasMutex);
+            auto connectionSchema = connectionSchemas.find(connection);
+            if ( connectionSchema == connectionSchemas.end() ) {
+                schemaLocker.unlock();
+
+                closeConnection(connection, "Schema encoded tuples before a schema");
+                return;
+            }
+            const TupleSchema& schema = connectionSchema->second;
+            schemaLocker.unlock();
+
+            BoltExecutor* executor = BoltExecutor::FindLocal(SUPERVISOR_ADDRESSES.at(supervisorName), taskIndex);
+            ByteArrayReader reader(body);
+            for ( int32_t tupleIndex = 0; tupleIndex < tupleCount; tupleIndex ++ ) {
+                Values values;
+                if ( !schema.Decode(reader, values) ) {
+                    closeConnection(connection, "Truncated schema encoded tuples");
+                    return;
+                }
+
+                if ( executor ) {
+                    executor->SendData(std::move(values));
+                }
+            }
+
+            pauseWhileOverloaded(connection, executor);
+            sendResponse(connection, receivedPackage.GetRequestId());
+
+            return;
+        }
+
+        receivedPackage.DeserializeVariants(body);
         Command command(receivedPackage);
 
-        dispatcher.Dispatch(command);
+        if ( command.GetType() == Command::Type::Schema ) {
+            TupleSchema schema = TupleSchema::FromVariants(command.GetArgs(), 1);
+            // Peers only declare schemas which can encode their tuples
+            if ( schema.IsEmpty() ) {
+                closeConnection(connection, "Invalid schema");
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> schemaLocker(connectionSchemasMutex);
+                connectionSchemas[connection] = schema;
+            }
+
+            sendResponse(connection, command.GetRequestId());
+
+            return;
+        }
+
+        // A tuple carries the sending supervisor and the task index in front of its values
+        if ( command.GetType() == Command::Type::Data ) {
+            const Variants& args = command.GetArgs();
+            if ( !isInteger(args, 1) ) {
+                closeConnection(connection, "Tuple without task index");
+                return;
+            }
+
+            int32_t taskIndex = args[1].GetIntValue();
+
+            Values values;
+            for ( auto arg = args.begin() + 2; arg != args.end(); ++ arg ) {
+                values.push_back(Value::FromVariant(*arg));
+            }
+
+            BoltExecutor* executor = BoltExecutor::FindLocal(SUPERVISOR_ADDRESSES.at(supervisorName), taskIndex);
+            if ( executor ) {
+                executor->SendData(std::move(values));
+            }
+
+            pauseWhileOverloaded(connection, executor);
+            sendResponse(connection, command.GetRequestId());
+
+            return;
+        }
+
+        if ( command.GetType() == Command::Type::BatchData ) {
+            const Variants& args = command.GetArgs();
+            if ( !isInteger(args, 1) || !isInteger(args, 2) ) {
+                closeConnection(connection, "Tuples without task index or tuple count");
+                return;
+            }
+
+            int32_t taskIndex = args[1].GetIntValue();
+            int32_t tupleCount = args[2].GetIntValue();
+            BoltExecutor* executor = BoltExecutor::FindLocal(SUPERVISOR_ADDRESSES.at(supervisorName), taskIndex);
+
+            // Every tuple is prefixed with the count of its values
+            size_t argIndex = 3;
+            for ( int32_t tupleIndex = 0; tupleIndex < tupleCount && argIndex < args.size(); tupleIndex ++ ) {
+                if ( !isInteger(args, argIndex) ) {
+                    closeConnection(connection, "Tuple without value count");
+                    return;
+                }
+
+                size_t valueCount = args[argIndex].GetIntValue();
+                argIndex ++;
+
+                Values values;
+                for ( size_t valueIndex = 0; valueIndex < valueCount && argIndex < args.size(); valueIndex ++ ) {
+                    values.push_back(Value::FromVariant(args[argIndex]));
+                    argIndex ++;
+                }
+
+                if ( executor ) {
+                    executor->SendData(std::move(values));
+                }
+            }
+
+            pauseWhileOverloaded(connection, executor);
+            sendResponse(connection, command.GetRequestId());
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> dispatcherLocker(dispatcherMutex);
+        dispatcher.Dispatch(command, connection);
+    });
+
+    netListener.OnDisconnect([&](meshy::TcpStream* connection) {
+        {
+            std::lock_guard<std::mutex> schemaLocker(connectionSchemasMutex);
+            connectionSchemas.erase(connection);
+        }
+
+        std::lock_guard<std::mutex> pausedLocker(pausedConnectionsMutex);
+        pausedConnections.erase(connection);
     });
 
     netListener.StartListen();
@@ -20,15 +20,46 @@
 
 namespace hurricane {
 	namespace base {
-		std::map<int8_t, std::shared_ptr<Writable>> Writables =
+		const int32_t DataPackage::REQUEST_ID_OFFSET;
+		const int32_t DataPackage::HEAD_SIZE;
+
+		WritableMap Writables =
 		{
 			{ 0, std::shared_ptr<Writable>(new IntWritable) },
-			{ 3, std::shared_ptr<Writable>(new StringWritable) }
+			{ 1, std::shared_ptr<Writable>(new BooleanWritable) },
+			{ 2, std::shared_ptr<Writable>(new FloatWritable) },
+			{ 3, std::shared_ptr<Writable>(new StringWritable) },
+			{ 4, std::shared_ptr<Writable>(new CharacterWritable) },
+			{ 5, std::shared_ptr<Writable>(new Int8Writable) },
+			{ 6, std::shared_ptr<Writable>(new Int16Writable) },
+			{ 7, std::shared_ptr<Writable>(new Int64Writable) },
+			{ 8, std::shared_ptr<Writable>(new DoubleWritable) }
+		};
+
+		// Single byte and floating point values are already as small as they get
+		WritableMap CompactWritables =
+		{
+			{ 0, std::shared_ptr<Writable>(new CompactIntWritable) },
+			{ 1, Writables[1] },
+			{ 2, Writables[2] },
+			{ 3, std::shared_ptr<Writable>(new CompactStringWritable) },
+			{ 4, Writables[4] },
+			{ 5, Writables[5] },
+			{ 6, std::shared_ptr<Writable>(new CompactInt16Writable) },
+			{ 7, std::shared_ptr<Writable>(new CompactInt64Writable) },
+			{ 8, Writables[8] }
 		};
 
 		std::map<Variant::Type, int8_t> Variant::TypeCodes = {
 			{ Variant::Type::Integer, 0 },
-			{ Variant::Type::String, 3 }
+			{ Variant::Type::Boolean, 1 },
+			{ Variant::Type::Float, 2 },
+			{ Variant::Type::String, 3 },
+			{ Variant::Type::Character, 4 },
+			{ Variant::Type::Int8, 5 },
+			{ Variant::Type::Int16, 6 },
+			{ Variant::Type::Int64, 7 },
+			{ Variant::Type::Double, 8 }
 		};
 
 		std::map < Variant::Type, std::string > Variant::TypeNames = {
@@ -36,7 +67,12 @@ namespace hurricane {
 			{ Variant::Type::Integer, "Integer" },
 			{ Variant::Type::Boolean, "Boolean" },
 			{ Variant::Type::Float, "Float" },
-			{ Variant::Type::String, "String" }
+			{ Variant::Type::String, "String" },
+			{ Variant::Type::Character, "Character" },
+			{ Variant::Type::Int8, "Int8" },
+			{ Variant::Type::Int16, "Int16" },
+			{ Variant::Type::Int64, "Int64" },
+			{ Variant::Type::Double, "Double" }
 		};
 	}
 }
\ No newline at end of file
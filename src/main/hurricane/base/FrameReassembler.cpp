@@ -0,0 +1,90 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "hurricane/base/FrameReassembler.h"
+
+#include <algorithm>
+
+namespace hurricane {
+    namespace base {
+        const int32_t FrameReassembler::LENGTH_SIZE;
+        const int32_t FrameReassembler::HEAD_SIZE;
+        const int32_t FrameReassembler::DEFAULT_MAX_FRAME_SIZE;
+
+        bool FrameReassembler::Feed(const char* data, int32_t size, FrameHandler handler) {
+            const char* cursor = data;
+            const char* end = data + size;
+
+            // Complete the frame left over by the previous reads first, only the missing bytes are appended
+            if ( !_buffer.empty() ) {
+                if ( _buffer.size() < size_t(LENGTH_SIZE) ) {
+                    int32_t missing = std::min(int32_t(LENGTH_SIZE - _buffer.size()), int32_t(end - cursor));
+                    _buffer.insert(_buffer.end(), cursor, cursor + missing);
+                    cursor += missing;
+
+                    if ( _buffer.size() < size_t(LENGTH_SIZE) ) {
+                        return true;
+                    }
+
+                    if ( !IsValidLength(PeekLength(_buffer.data())) ) {
+                        Reset();
+                        return false;
+                    }
+
+                    _buffer.reserve(PeekLength(_buffer.data()));
+                }
+
+                int32_t length = PeekLength(_buffer.data());
+                int32_t missing = std::min(int32_t(length - _buffer.size()), int32_t(end - cursor));
+                _buffer.insert(_buffer.end(), cursor, cursor + missing);
+                cursor += missing;
+
+                if ( _buffer.size() < size_t(length) ) {
+                    return true;
+                }
+
+                handler(_buffer.data(), length);
+                _buffer.clear();
+            }
+
+            while ( end - cursor >= LENGTH_SIZE ) {
+                int32_t length = PeekLength(cursor);
+                if ( !IsValidLength(length) ) {
+                    Reset();
+                    return false;
+                }
+
+                if ( end - cursor < length ) {
+                    break;
+                }
+
+                handler(cursor, length);
+                cursor += length;
+            }
+
+            if ( cursor < end ) {
+                if ( end - cursor >= LENGTH_SIZE ) {
+                    _buffer.reserve(PeekLength(cursor));
+                }
+                _buffer.insert(_buffer.end(), cursor, end);
+            }
+
+            return true;
+        }
+    }
+}
@@ -18,33 +18,206 @@
 
 #include "hurricane/Hurricane.h"
 #include "hurricane/base/NetConnector.h"
+#include "hurricane/base/DataPackage.h"
 #include "Meshy.h"
+#include "utils/common_utils.h"
 
-#include <thread>
-#include <chrono>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+
+const int32_t NetConnector::DEFAULT_RESPONSE_TIMEOUT_MILLISECONDS;
+
+NetConnector::~NetConnector()
+{
+#ifdef OS_LINUX
+    // The loop closes the stream on the hang up, its callbacks find the connector gone
+    if ( _client ) {
+        shutdown(_client->GetNativeSocket(), SHUT_RDWR);
+    }
+#endif
+
+    FailRequests();
+}
 
 void NetConnector::Connect()
 {
-    _client = meshy::TcpClient::Connect(_host.GetHost(), _host.GetPort(), nullptr);
+#ifdef OS_LINUX
+    // A listener on the same host is also reachable through its unix socket,
+    // tcp is kept for the peers which do not listen on one
+    if ( meshy::IsLocalHost(_host.GetHost()) ) {
+        _client = meshy::TcpClient::ConnectLocal(_host.GetPort(), nullptr);
+    }
+#endif
+
+    if ( !_client ) {
+        _client = meshy::TcpClient::Connect(_host.GetHost(), _host.GetPort(), nullptr);
+    }
+
+    if ( _noDelay ) {
+        SetNoDelay(true);
+    }
+
+    // The stream may still be served by the io loop after the connector has been released
+    std::weak_ptr<NetConnector> weakConnector = shared_from_this();
+    _client->OnDataIndication([weakConnector](const char* buf, int64_t size) {
+        std::shared_ptr<NetConnector> connector = weakConnector.lock();
+        if ( !connector ) {
+            return;
+        }
+
+        NetConnector* self = connector.get();
+        bool valid = connector->_reassembler.Feed(buf, int32_t(size), [self](const char* frame, int32_t frameSize) {
+            self->OnFrame(frame, frameSize);
+        });
+
+        // The frame boundaries of the stream are lost, no later response can be matched to its request
+        if ( !valid ) {
+            std::cerr << "Invalid frame length received, closing the connection" << std::endl;
+#ifdef OS_LINUX
+            shutdown(connector->_client->GetNativeSocket(), SHUT_RDWR);
+#endif
+            connector->FailRequests();
+        }
+    });
+    _client->OnCloseIndication([weakConnector]() {
+        std::shared_ptr<NetConnector> connector = weakConnector.lock();
+        if ( connector ) {
+            connector->FailRequests();
+        }
+    });
+}
+
+void NetConnector::SetNoDelay(bool noDelay)
+{
+    _noDelay = noDelay;
+
+#ifdef OS_LINUX
+    if ( _client ) {
+        meshy::SetNoDelay(_client->GetNativeSocket(), noDelay);
+    }
+#endif
+}
+
+int32_t NetConnector::SendRequest(char* buffer, int32_t size, ResponseHandler handler)
+{
+    // 0 is left for frames which do not expect a response
+    int32_t requestId = ++ _nextRequestId;
+    if ( requestId == 0 ) {
+        requestId = ++ _nextRequestId;
+    }
+
+    hurricane::base::DataPackage::PatchRequestId(buffer, requestId);
+
+    // The handler has to be registered before the request is sent, the response may arrive
+    // on the io loop thread before Send returns
+    std::unique_lock<std::mutex> locker(_requestMutex);
+    if ( _closed ) {
+        locker.unlock();
+        handler(nullptr, 0);
+
+        return requestId;
+    }
+
+    _pendingRequests[requestId] = handler;
+    _client->Send(buffer, size);
+
+    return requestId;
 }
 
-int32_t NetConnector::SendAndReceive(const char * buffer, int32_t size, char* resultBuffer, int32_t resultSize)
+std::future<hurricane::base::ByteArray> NetConnector::SendRequest(char* buffer, int32_t size)
 {
-    _client->Send(meshy::ByteArray(buffer, size));
+    std::shared_ptr<std::promise<hurricane::base::ByteArray>> result =
+        std::make_shared<std::promise<hurricane::base::ByteArray>>();
 
-    bool receivedData = false;
-    _client->OnDataIndication([&receivedData, &resultSize, &resultBuffer](const char* buf, int64_t size) {
-        if ( resultSize > size) {
-            resultSize = size;
+    SendRequest(buffer, size, [result](const char* frame, int32_t frameSize) {
+        if ( !frame ) {
+            result->set_exception(std::make_exception_ptr(
+                std::runtime_error("Connection closed before the response arrived")));
+            return;
         }
 
-        memcpy(resultBuffer, buf, resultSize);
-        receivedData = true;
+        result->set_value(hurricane::base::ByteArray(frame, frameSize));
     });
 
-    while ( !receivedData ) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return result->get_future();
+}
+
+void NetConnector::Send(char* buffer, int32_t size)
+{
+    hurricane::base::DataPackage::PatchRequestId(buffer, 0);
+
+    std::unique_lock<std::mutex> locker(_requestMutex);
+    _client->Send(buffer, size);
+}
+
+int32_t NetConnector::SendAndReceive(char * buffer, int32_t size, char* resultBuffer, int32_t resultSize)
+{
+    std::shared_ptr<std::promise<hurricane::base::ByteArray>> response =
+        std::make_shared<std::promise<hurricane::base::ByteArray>>();
+    std::future<hurricane::base::ByteArray> responseFuture = response->get_future();
+
+    // A failed request is answered with an empty frame, a response is never empty
+    int32_t requestId = SendRequest(buffer, size, [response](const char* frame, int32_t frameSize) {
+        response->set_value(frame ? hurricane::base::ByteArray(frame, frameSize) : hurricane::base::ByteArray());
+    });
+
+    if ( responseFuture.wait_for(_responseTimeout) != std::future_status::ready ) {
+        CancelRequest(requestId);
+        return -1;
+    }
+
+    hurricane::base::ByteArray result = responseFuture.get();
+    if ( result.empty() ) {
+        return -1;
+    }
+
+    if ( resultSize > int32_t(result.size()) ) {
+        resultSize = int32_t(result.size());
     }
 
+    memcpy(resultBuffer, result.data(), resultSize);
+
     return resultSize;
-}
\ No newline at end of file
+}
+
+void NetConnector::OnFrame(const char* frame, int32_t size)
+{
+    ResponseHandler handler;
+    {
+        std::unique_lock<std::mutex> locker(_requestMutex);
+        auto pendingRequest = _pendingRequests.find(hurricane::base::DataPackage::PeekRequestId(frame));
+        if ( pendingRequest == _pendingRequests.end() ) {
+            return;
+        }
+
+        handler = pendingRequest->second;
+        _pendingRequests.erase(pendingRequest);
+    }
+
+    handler(frame, size);
+}
+
+void NetConnector::CancelRequest(int32_t requestId)
+{
+    std::unique_lock<std::mutex> locker(_requestMutex);
+    _pendingRequests.erase(requestId);
+}
+
+void NetConnector::FailRequests()
+{
+    std::vector<ResponseHandler> handlers;
+    {
+        std::unique_lock<std::mutex> locker(_requestMutex);
+        _closed = true;
+
+        for ( auto& pendingRequest : _pendingRequests ) {
+            handlers.push_back(pendingRequest.second);
+        }
+        _pendingRequests.clear();
+    }
+
+    for ( ResponseHandler& handler : handlers ) {
+        handler(nullptr, 0);
+    }
+}
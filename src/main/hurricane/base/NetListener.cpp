@@ -19,6 +19,7 @@
 #include "hurricane/Hurricane.h"
 
 #include "hurricane/base/NetListener.h"
+#include "hurricane/base/FrameReassembler.h"
 #include "eventqueue.h"
 #include "eventqueueloop.h"
 #include "IoLoop.h"
@@ -37,10 +38,44 @@ void NetListener::StartListen()
 {
     meshy::IoLoop::Get()->Start();
 
-    _server.Listen(_host.GetHost(), _host.GetPort());
+    // The loops accept as soon as the server listens, so the handler has to be in place first
     _server.OnConnectIndication([this](meshy::IStream* stream) {
-        stream->OnDataIndication([stream, this](const char* buf, int64_t size) mutable {
-            this->_receiver(dynamic_cast<meshy::TcpStream*>(stream), buf, size);
+        // Every connection reassembles its own frames, a read may carry several frames or only a part of one
+        std::shared_ptr<hurricane::base::FrameReassembler> reassembler =
+            std::make_shared<hurricane::base::FrameReassembler>();
+        meshy::TcpStream* connection = dynamic_cast<meshy::TcpStream*>(stream);
+
+        stream->OnDataIndication([connection, reassembler, this](const char* buf, int64_t size) mutable {
+            bool valid = reassembler->Feed(buf, int32_t(size), [connection, this](const char* frame, int32_t frameSize) {
+                this->_receiver(connection, frame, frameSize);
+            });
+
+            // The frame boundaries of the stream are lost, nothing after this point can be decoded
+            if ( !valid ) {
+                std::cerr << "Invalid frame length received, closing the connection" << std::endl;
+                Close(connection);
+            }
         });
     });
+
+    _server.OnDisconnectIndication([this](meshy::IStream* stream) {
+        if ( _disconnectReceiver ) {
+            _disconnectReceiver(dynamic_cast<meshy::TcpStream*>(stream));
+        }
+    });
+
+    _server.Listen(_host.GetHost(), _host.GetPort());
+    // Peers on the same host connect through a unix socket and skip the loopback tcp stack
+    if ( _server.ListenLocal(_host.GetPort()) < 0 ) {
+        std::cout << "Local socket unavailable, same host peers use tcp" << std::endl;
+    }
+}
+
+void NetListener::Close(meshy::TcpStream* connection)
+{
+#ifdef WIN32
+    shutdown(connection->GetNativeSocket(), SD_BOTH);
+#else
+    shutdown(connection->GetNativeSocket(), SHUT_RDWR);
+#endif
 }
\ No newline at end of file
@@ -20,25 +20,279 @@
 
 #include "hurricane/base/OutputCollector.h"
 #include "hurricane/topology/ITopology.h"
+#include "hurricane/bolt/BoltExecutor.h"
 
 #include <iostream>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace hurricane {
 namespace base {
 
+const size_t OutputCollector::DEFAULT_BATCH_SIZE;
+const std::chrono::milliseconds OutputCollector::DEFAULT_BATCH_LINGER(1);
+const size_t OutputCollector::DEFAULT_BATCH_BYTES;
+const size_t OutputCollector::DEFAULT_MIN_BATCH_BYTES;
+const size_t OutputCollector::DEFAULT_MAX_BATCH_BYTES;
+const size_t OutputCollector::DEFAULT_SEND_QUEUE_HIGH_WATERMARK;
+const size_t OutputCollector::DEFAULT_SEND_QUEUE_LOW_WATERMARK;
+
+// Close to the encoded size of the tuple, only used to decide when a batch is full
+static size_t EstimateTupleSize(const Values& values) {
+	size_t size = 0;
+	for ( const Value& value : values ) {
+		size += value.GetType() == Value::Type::String ? value.ToString().size() + 5 : 9;
+	}
+
+	return size;
+}
+
+// Sends the pending batches once their linger time expired, so that a task which stops
+// emitting does not hold back its last tuples. One thread serves all the collectors.
+class LingerTimer {
+public:
+	// Never destroyed, collectors may outlive the static objects at exit
+	static LingerTimer& Get() {
+		static LingerTimer* timer = new LingerTimer;
+		return *timer;
+	}
+
+	void Schedule(OutputCollector* collector, std::chrono::steady_clock::time_point deadline) {
+		std::unique_lock<std::mutex> locker(_mutex);
+		bool earliest = _deadlines.empty() || deadline < _deadlines.begin()->first;
+		_deadlines.insert({ deadline, collector });
+
+		if ( earliest ) {
+			_condition.notify_all();
+		}
+	}
+
+	// Returns once the timer does not use the collector anymore
+	void Cancel(OutputCollector* collector) {
+		std::unique_lock<std::mutex> locker(_mutex);
+		for ( auto deadline = _deadlines.begin(); deadline != _deadlines.end(); ) {
+			if ( deadline->second == collector ) {
+				deadline = _deadlines.erase(deadline);
+			}
+			else {
+				++ deadline;
+			}
+		}
+
+		while ( _sendingCollector == collector ) {
+			_condition.wait(locker);
+		}
+	}
+
+private:
+	LingerTimer() : _sendingCollector(nullptr) {
+		std::thread(&LingerTimer::ThreadMain, this).detach();
+	}
+
+	void ThreadMain() {
+		std::unique_lock<std::mutex> locker(_mutex);
+		while ( true ) {
+			if ( _deadlines.empty() ) {
+				_condition.wait(locker);
+				continue;
+			}
+
+			auto deadline = _deadlines.begin();
+			// The deadline may be cancelled while the thread waits, so it is copied
+			std::chrono::steady_clock::time_point time = deadline->first;
+			if ( time > std::chrono::steady_clock::now() ) {
+				_condition.wait_until(locker, time);
+				continue;
+			}
+
+			// The collector takes its own lock, the timer lock is not held meanwhile
+			_sendingCollector = deadline->second;
+			_deadlines.erase(deadline);
+			locker.unlock();
+			_sendingCollector->SendLingeringBatch();
+			locker.lock();
+
+			_sendingCollector = nullptr;
+			_condition.notify_all();
+		}
+	}
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::multimap<std::chrono::steady_clock::time_point, OutputCollector*> _deadlines;
+	OutputCollector* _sendingCollector;
+};
+
+OutputCollector::~OutputCollector() {
+	LingerTimer::Get().Cancel(this);
+
+	SendBatch();
+
+	if ( _commander ) {
+		delete _commander;
+	}
+}
+
+void OutputCollector::SetDestination(const NetAddress& address, int destIndex, const std::string& supervisorName,
+	const Fields& fields, int32_t ackWindowTuples) {
+	bolt::BoltExecutor* localExecutor = bolt::BoltExecutor::FindLocal(address, destIndex);
+	if ( localExecutor ) {
+		SetLocalDestination(localExecutor);
+		return;
+	}
+
+	message::SupervisorCommander* commander = new message::SupervisorCommander(address, supervisorName);
+	if ( _strategy == Strategy::Global ) {
+		commander->SetSchemaFields(fields);
+		commander->SetAckWindow(ackWindowTuples, message::SupervisorCommander::DEFAULT_ACK_WINDOW_BYTES);
+		// The tuples in the window are not lost with the connection
+		commander->SetRetransmitOnReconnect(true);
+	}
+	SetCommander(commander);
+	SetTaskIndex(destIndex);
+}
+
 void OutputCollector::Emit(const Values& values) {
+	Emit(Values(values));
+}
+
+void OutputCollector::Emit(Values&& values) {
+	_emittedCount ++;
+
 	if ( _strategy == Strategy::Global ) {
-		if ( _commander ) {
-			_commander->SendTuple(this->_taskIndex, values);
+		std::unique_lock<std::mutex> locker(_batchMutex);
+		// Batching only amortizes frames, a local destination takes every tuple as it comes
+		if ( _localDestination ) {
+			SendTuple(std::move(values));
+			return;
+		}
+
+		if ( !_commander ) {
+			return;
+		}
+
+		_batchBytes += EstimateTupleSize(values);
+		_batch.push_back(std::move(values));
+		if ( _batch.size() >= _batchSize || _batchBytes >= _batchBytesThreshold ) {
+			SendBatch(SendReason::Full);
+		}
+		else if ( _batch.size() == 1 ) {
+			_batchDeadline = std::chrono::steady_clock::now() + _batchLinger;
+			LingerTimer::Get().Schedule(this, _batchDeadline);
 		}
 	}
 	else if ( _strategy == Strategy::Random ) {
 		this->RandomDestination();
-        _commander->SendTuple(this->_taskIndex, values);
+		SendTuple(std::move(values));
 	}
 	else if ( _strategy == Strategy::Group ) {
 		this->GroupDestination();
-        _commander->SendTuple(this->_taskIndex, values);
+		SendTuple(std::move(values));
+	}
+}
+
+void OutputCollector::SendTuple(Values&& values) {
+	if ( _localDestination ) {
+		(*_localPendingCount) ++;
+		_localDestination->SendData(std::move(values), _localPendingCount);
+	}
+	else if ( _commander ) {
+		_commander->SendTuple(_taskIndex, values);
+	}
+}
+
+bool OutputCollector::IsThrottled() {
+	std::unique_lock<std::mutex> locker(_batchMutex);
+	if ( _localDestination ) {
+		return _localDestination->IsOverloaded();
+	}
+
+	if ( !_commander ) {
+		return false;
+	}
+
+	if ( !_commander->IsAckWindowOpen() ) {
+		return true;
+	}
+
+	size_t sendQueueSize = _commander->GetSendQueueSize();
+	if ( sendQueueSize >= _sendQueueHighWatermark ) {
+		_sendQueueThrottled = true;
+	}
+	else if ( sendQueueSize <= _sendQueueLowWatermark ) {
+		_sendQueueThrottled = false;
+	}
+
+	return _sendQueueThrottled;
+}
+
+void OutputCollector::WaitWhileThrottled() {
+	IdleStrategy idleStrategy;
+	while ( IsThrottled() ) {
+		idleStrategy.Idle();
+	}
+}
+
+int64_t OutputCollector::GetPendingCount() {
+	std::unique_lock<std::mutex> locker(_batchMutex);
+	int64_t pendingCount = int64_t(_batch.size()) + *_localPendingCount;
+	if ( _commander ) {
+		pendingCount += _commander->GetUnackedTupleCount();
+	}
+
+	return pendingCount;
+}
+
+void OutputCollector::Flush() {
+	std::unique_lock<std::mutex> locker(_batchMutex);
+	SendBatch();
+}
+
+void OutputCollector::SendBatch(int reason) {
+	if ( _batch.empty() ) {
+		return;
+	}
+
+	if ( reason != SendReason::Forced ) {
+		// A batch filling up means the flow is bound by throughput, large writes are cheaper
+		// and the kernel may coalesce them further. Batches sent by the linger or tuples sent
+		// one by one are bound by latency and should leave at once.
+		bool noDelay = reason == SendReason::Linger || _batchSize == 1;
+		if ( noDelay != _noDelay ) {
+			_commander->SetNoDelay(noDelay);
+			_noDelay = noDelay;
+		}
+
+		if ( reason == SendReason::Linger ) {
+			_batchBytesThreshold = std::max(_batchBytes, _minBatchBytes);
+		}
+		else if ( _batchBytes >= _batchBytesThreshold ) {
+			_batchBytesThreshold = std::min(_batchBytesThreshold * 2, _maxBatchBytes);
+		}
+	}
+
+	if ( _commander->IsConnectionClosed() ) {
+		_commander->Reconnect();
+	}
+
+	if ( _batch.size() == 1 ) {
+		_commander->SendTuple(_taskIndex, _batch.front());
+	}
+	else {
+		_commander->SendTuples(_taskIndex, _batch);
+	}
+
+	_batch.clear();
+	_batchBytes = 0;
+}
+
+void OutputCollector::SendLingeringBatch() {
+	std::unique_lock<std::mutex> locker(_batchMutex);
+	// The batch the deadline was set for may have been sent already, a newer one has its own deadline
+	if ( !_batch.empty() && std::chrono::steady_clock::now() >= _batchDeadline ) {
+		SendBatch(SendReason::Linger);
 	}
 }
 
@@ -0,0 +1,218 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "hurricane/base/Placement.h"
+
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#ifdef OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace hurricane {
+    namespace base {
+        // Parses the cpu lists of sysfs, such as "0-3,8-11"
+        static std::vector<int32_t> ParseCpuList(const std::string& cpuList) {
+            std::vector<int32_t> cpus;
+            std::istringstream ranges(cpuList);
+            std::string range;
+
+            while ( std::getline(ranges, range, ',') ) {
+                if ( range.empty() || range[0] < '0' || range[0] > '9' ) {
+                    continue;
+                }
+
+                size_t separator = range.find('-');
+                int32_t first = std::stoi(range.substr(0, separator));
+                int32_t last = separator == std::string::npos ? first : std::stoi(range.substr(separator + 1));
+                for ( int32_t cpu = first; cpu <= last; cpu ++ ) {
+                    cpus.push_back(cpu);
+                }
+            }
+
+            return cpus;
+        }
+
+        // The cpus of every node the process may run on, a machine without NUMA is one node
+        static std::vector<std::vector<int32_t>> ReadNodeCpus() {
+            std::vector<std::vector<int32_t>> nodeCpus;
+
+#ifdef OS_LINUX
+            cpu_set_t allowedCpus;
+            CPU_ZERO(&allowedCpus);
+            bool hasAllowedCpus = sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) == 0;
+
+            std::ifstream onlineFile("/sys/devices/system/node/online");
+            std::string onlineNodes;
+            std::getline(onlineFile, onlineNodes);
+
+            for ( int32_t node : ParseCpuList(onlineNodes) ) {
+                std::ifstream cpuListFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpuList;
+                std::getline(cpuListFile, cpuList);
+
+                std::vector<int32_t> cpus;
+                for ( int32_t cpu : ParseCpuList(cpuList) ) {
+                    if ( !hasAllowedCpus || ( cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowedCpus) ) ) {
+                        cpus.push_back(cpu);
+                    }
+                }
+
+                if ( !cpus.empty() ) {
+                    nodeCpus.push_back(cpus);
+                }
+            }
+#endif
+
+            if ( nodeCpus.empty() ) {
+                std::vector<int32_t> cpus;
+                int32_t cpuCount = std::max(int32_t(std::thread::hardware_concurrency()), 1);
+                for ( int32_t cpu = 0; cpu < cpuCount; cpu ++ ) {
+                    cpus.push_back(cpu);
+                }
+
+                nodeCpus.push_back(cpus);
+            }
+
+            return nodeCpus;
+        }
+
+        Placement::Placement(int32_t policy) : _policy(policy), _nodeCpus(ReadNodeCpus()) {
+            _nextCpus.resize(_nodeCpus.size(), 0);
+        }
+
+        void Placement::Plan(const std::map<std::string, std::vector<std::string>>& network) {
+            // Union find over the task names, every root ends up naming one connected part
+            std::map<std::string, std::string> parents;
+            std::function<std::string(const std::string&)> findRoot = [&](const std::string& taskName) {
+                auto parent = parents.find(taskName);
+                if ( parent == parents.end() ) {
+                    parents[taskName] = taskName;
+                    return taskName;
+                }
+
+                if ( parent->second == taskName ) {
+                    return taskName;
+                }
+
+                std::string root = findRoot(parent->second);
+                parents[taskName] = root;
+
+                return root;
+            };
+
+            for ( const auto& destinations : network ) {
+                std::string sourceRoot = findRoot(destinations.first);
+                for ( const std::string& destination : destinations.second ) {
+                    std::string destinationRoot = findRoot(destination);
+                    if ( destinationRoot != sourceRoot ) {
+                        parents[destinationRoot] = sourceRoot;
+                    }
+                }
+            }
+
+            std::map<std::string, std::vector<std::string>> parts;
+            for ( const auto& parent : parents ) {
+                parts[findRoot(parent.first)].push_back(parent.first);
+            }
+
+            std::vector<std::vector<std::string>> sortedParts;
+            for ( auto& part : parts ) {
+                sortedParts.push_back(part.second);
+            }
+            std::stable_sort(sortedParts.begin(), sortedParts.end(),
+                [](const std::vector<std::string>& left, const std::vector<std::string>& right) {
+                return left.size() > right.size();
+            });
+
+            std::vector<size_t> nodeTasks(_nodeCpus.size(), 0);
+            _taskNodes.clear();
+            for ( const auto& part : sortedParts ) {
+                int32_t node = int32_t(std::min_element(nodeTasks.begin(), nodeTasks.end()) - nodeTasks.begin());
+                for ( const std::string& taskName : part ) {
+                    _taskNodes[taskName] = node;
+                }
+
+                nodeTasks[node] += part.size();
+            }
+        }
+
+        int32_t Placement::GetNode(const std::string& taskName) const {
+            auto taskNode = _taskNodes.find(taskName);
+            if ( taskNode == _taskNodes.end() ) {
+                return 0;
+            }
+
+            return taskNode->second;
+        }
+
+        void Placement::PinTask(const std::string& taskName) {
+            Pin(GetNode(taskName), false);
+        }
+
+        void Placement::PinThread(int32_t index) {
+            Pin(index % GetNodeCount(), false);
+        }
+
+        void Placement::RunOnNode(int32_t node, std::function<void()> function) {
+            if ( _policy == Policy::None ) {
+                function();
+                return;
+            }
+
+            std::thread nodeThread([this, node, &function]() {
+                Pin(node, true);
+                function();
+            });
+            nodeThread.join();
+        }
+
+        void Placement::Pin(int32_t node, bool anyCore) {
+            if ( _policy == Policy::None || node < 0 || node >= GetNodeCount() ) {
+                return;
+            }
+
+            const std::vector<int32_t>& cpus = _nodeCpus[node];
+            std::vector<int32_t> pinnedCpus;
+            if ( _policy == Policy::Core && !anyCore ) {
+                std::unique_lock<std::mutex> locker(_nextCpusMutex);
+                pinnedCpus.push_back(cpus[_nextCpus[node] % cpus.size()]);
+                _nextCpus[node] ++;
+            }
+            else {
+                pinnedCpus = cpus;
+            }
+
+#ifdef OS_LINUX
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for ( int32_t cpu : pinnedCpus ) {
+                if ( cpu < CPU_SETSIZE ) {
+                    CPU_SET(cpu, &cpuSet);
+                }
+            }
+
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+        }
+    }
+}
@@ -0,0 +1,329 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "hurricane/base/TaskScheduler.h"
+
+namespace hurricane {
+    namespace base {
+        const int32_t TaskScheduler::STEAL_ROUNDS;
+
+        // Set by WorkerMain, a thread is a worker of at most one scheduler
+        static thread_local TaskScheduler* CurrentScheduler = nullptr;
+        static thread_local int32_t CurrentWorker = -1;
+
+        void ScheduledTask::Notify() {
+            TaskScheduler* scheduler = _scheduler.load(std::memory_order_acquire);
+            if ( !scheduler ) {
+                return;
+            }
+
+            // A task which is already queued is left alone, so a busy task costs a load per notification
+            int32_t state = _state.load();
+            while ( true ) {
+                if ( state == State::Idle ) {
+                    if ( _state.compare_exchange_weak(state, State::Queued) ) {
+                        scheduler->Submit(this);
+                        return;
+                    }
+                }
+                else if ( state == State::Running ) {
+                    if ( _state.compare_exchange_weak(state, State::Notified) ) {
+                        return;
+                    }
+                }
+                else {
+                    return;
+                }
+            }
+        }
+
+        TaskScheduler::TaskScheduler(int32_t workerCount, Placement* placement) :
+            _placement(placement), _running(true), _nextWorker(0),
+            _queuedCount(0), _sleepingCount(0) {
+            if ( workerCount <= 0 ) {
+                workerCount = int32_t(std::thread::hardware_concurrency());
+            }
+            if ( workerCount <= 0 ) {
+                workerCount = 1;
+            }
+
+            // Placement::PinThread puts the worker index on node index modulo the node count
+            bool placed = _placement && _placement->GetPolicy() != Placement::Policy::None &&
+                _placement->GetNodeCount() > 0;
+            for ( int32_t workerIndex = 0; workerIndex < workerCount; workerIndex ++ ) {
+                _workers.push_back(std::unique_ptr<Worker>(new Worker));
+                _workers.back()->node = placed ? workerIndex % _placement->GetNodeCount() : -1;
+            }
+            // The workers look each other up, so they are all created before the first one starts
+            for ( int32_t workerIndex = 0; workerIndex < workerCount; workerIndex ++ ) {
+                _workers[workerIndex]->thread = std::thread(&TaskScheduler::WorkerMain, this, workerIndex);
+            }
+
+            _timerThread = std::thread(&TaskScheduler::TimerMain, this);
+        }
+
+        TaskScheduler::~TaskScheduler() {
+            Stop();
+        }
+
+        void TaskScheduler::Schedule(ScheduledTask* task, int32_t node) {
+            if ( node < 0 || node >= int32_t(_workers.size()) || _workers[node]->node != node ) {
+                node = -1;
+            }
+
+            task->_node = node;
+            task->_state.store(ScheduledTask::State::Queued);
+            task->_scheduler.store(this, std::memory_order_release);
+
+            Push(NextWorker(node), task);
+        }
+
+        void TaskScheduler::Stop() {
+            if ( !_running.exchange(false) ) {
+                return;
+            }
+
+            {
+                std::unique_lock<std::mutex> locker(_sleepMutex);
+                _sleepCondition.notify_all();
+            }
+            {
+                std::unique_lock<std::mutex> locker(_timerMutex);
+                _timerCondition.notify_all();
+            }
+
+            for ( auto& worker : _workers ) {
+                worker->thread.join();
+            }
+            _timerThread.join();
+        }
+
+        void TaskScheduler::Submit(ScheduledTask* task) {
+            int32_t workerIndex = GetCurrentWorker();
+            if ( workerIndex < 0 || ( task->_node >= 0 && _workers[workerIndex]->node != task->_node ) ) {
+                workerIndex = NextWorker(task->_node);
+            }
+
+            Push(workerIndex, task);
+        }
+
+        int32_t TaskScheduler::NextWorker(int32_t node) {
+            int32_t workerCount = int32_t(_workers.size());
+            uint32_t next = _nextWorker ++;
+            if ( node < 0 ) {
+                return int32_t(next % workerCount);
+            }
+
+            // The workers of node are node, node + nodeCount, node + 2 * nodeCount...
+            int32_t nodeCount = _placement->GetNodeCount();
+            int32_t nodeWorkerCount = ( workerCount - node + nodeCount - 1 ) / nodeCount;
+
+            return node + int32_t(next % nodeWorkerCount) * nodeCount;
+        }
+
+        void TaskScheduler::Push(int32_t workerIndex, ScheduledTask* task) {
+            Worker& worker = *_workers[workerIndex];
+            {
+                std::unique_lock<std::mutex> locker(worker.mutex);
+                worker.tasks.push_back(task);
+            }
+
+            // Both counters are sequentially consistent, so either the worker going to sleep
+            // sees the task or the task sees the sleeping worker
+            _queuedCount ++;
+            if ( _sleepingCount.load() > 0 ) {
+                // Only the workers of its node may take a bound task, any other one would just stay awake
+                std::unique_lock<std::mutex> locker(_sleepMutex);
+                if ( task->_node >= 0 ) {
+                    _sleepCondition.notify_all();
+                }
+                else {
+                    _sleepCondition.notify_one();
+                }
+            }
+        }
+
+        ScheduledTask* TaskScheduler::Pop(int32_t workerIndex) {
+            Worker& worker = *_workers[workerIndex];
+            std::unique_lock<std::mutex> locker(worker.mutex);
+            if ( worker.tasks.empty() ) {
+                return nullptr;
+            }
+
+            ScheduledTask* task = worker.tasks.front();
+            worker.tasks.pop_front();
+            _queuedCount --;
+
+            return task;
+        }
+
+        ScheduledTask* TaskScheduler::Steal(int32_t workerIndex) {
+            int32_t workerCount = int32_t(_workers.size());
+            int32_t node = _workers[workerIndex]->node;
+            for ( int32_t offset = 1; offset < workerCount; offset ++ ) {
+                Worker& victim = *_workers[(workerIndex + offset) % workerCount];
+                std::unique_lock<std::mutex> locker(victim.mutex, std::try_to_lock);
+                if ( !locker.owns_lock() || victim.tasks.empty() ) {
+                    continue;
+                }
+
+                // A task bound to another node is left to the workers of that node
+                ScheduledTask* task = victim.tasks.back();
+                if ( task->_node >= 0 && task->_node != node ) {
+                    continue;
+                }
+
+                victim.tasks.pop_back();
+                _queuedCount --;
+
+                return task;
+            }
+
+            return nullptr;
+        }
+
+        void TaskScheduler::RunTask(int32_t workerIndex, ScheduledTask* task) {
+            task->_state.store(ScheduledTask::State::Running);
+
+            std::chrono::microseconds delay(0);
+            int32_t result = task->RunSlice(&delay);
+
+            if ( result == ScheduledTask::Result::Done ) {
+                task->_state.store(ScheduledTask::State::Done);
+                CancelTimers(task);
+                return;
+            }
+
+            if ( result == ScheduledTask::Result::Continue ) {
+                task->_state.store(ScheduledTask::State::Queued);
+                Push(workerIndex, task);
+                return;
+            }
+
+            // The timer is added while the task still runs, so the task cannot be done and
+            // destroyed by another worker before
+            if ( result == ScheduledTask::Result::Delay ) {
+                AddTimer(task, delay);
+            }
+
+            int32_t state = ScheduledTask::State::Running;
+            if ( !task->_state.compare_exchange_strong(state, ScheduledTask::State::Idle) ) {
+                task->_state.store(ScheduledTask::State::Queued);
+                Push(workerIndex, task);
+            }
+        }
+
+        void TaskScheduler::WaitForTask() {
+            std::unique_lock<std::mutex> locker(_sleepMutex);
+            _sleepingCount ++;
+            while ( _running && _queuedCount.load() == 0 ) {
+                _sleepCondition.wait(locker);
+            }
+            _sleepingCount --;
+        }
+
+        int32_t TaskScheduler::GetCurrentWorker() const {
+            if ( CurrentScheduler != this ) {
+                return -1;
+            }
+
+            return CurrentWorker;
+        }
+
+        void TaskScheduler::AddTimer(ScheduledTask* task, std::chrono::microseconds delay) {
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + delay;
+
+            std::unique_lock<std::mutex> locker(_timerMutex);
+            bool earliest = _timers.empty() || deadline < _timers.begin()->first;
+            _timers.insert({ deadline, task });
+
+            if ( earliest ) {
+                _timerCondition.notify_one();
+            }
+        }
+
+        void TaskScheduler::CancelTimers(ScheduledTask* task) {
+            std::unique_lock<std::mutex> locker(_timerMutex);
+            for ( auto timer = _timers.begin(); timer != _timers.end(); ) {
+                if ( timer->second == task ) {
+                    timer = _timers.erase(timer);
+                }
+                else {
+                    ++ timer;
+                }
+            }
+        }
+
+        void TaskScheduler::WorkerMain(int32_t workerIndex) {
+            CurrentScheduler = this;
+            CurrentWorker = workerIndex;
+
+            if ( _placement ) {
+                _placement->PinThread(workerIndex);
+            }
+
+            int32_t idleRounds = 0;
+
+            while ( _running ) {
+                ScheduledTask* task = Pop(workerIndex);
+                if ( !task ) {
+                    task = Steal(workerIndex);
+                }
+
+                if ( task ) {
+                    idleRounds = 0;
+                    RunTask(workerIndex, task);
+                    continue;
+                }
+
+                if ( idleRounds < STEAL_ROUNDS ) {
+                    idleRounds ++;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                idleRounds = 0;
+                WaitForTask();
+            }
+        }
+
+        void TaskScheduler::TimerMain() {
+            std::unique_lock<std::mutex> locker(_timerMutex);
+
+            while ( _running ) {
+                if ( _timers.empty() ) {
+                    _timerCondition.wait(locker);
+                    continue;
+                }
+
+                auto timer = _timers.begin();
+                // The timer may be cancelled while the thread waits, so the deadline is copied
+                std::chrono::steady_clock::time_point deadline = timer->first;
+                if ( deadline > std::chrono::steady_clock::now() ) {
+                    _timerCondition.wait_until(locker, deadline);
+                    continue;
+                }
+
+                // Notified under the lock, so CancelTimers leaves no notification in flight
+                ScheduledTask* task = timer->second;
+                _timers.erase(timer);
+                task->Notify();
+            }
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * licensed to the apache software foundation (asf) under one
+ * or more contributor license agreements.  see the notice file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  the asf licenses this file
+ * to you under the apache license, version 2.0 (the
+ * "license"); you may not use this file except in compliance
+ * with the license.  you may obtain a copy of the license at
+ *
+ * http://www.apache.org/licenses/license-2.0
+ *
+ * unless required by applicable law or agreed to in writing, software
+ * distributed under the license is distributed on an "as is" basis,
+ * without warranties or conditions of any kind, either express or implied.
+ * see the license for the specific language governing permissions and
+ * limitations under the license.
+ */
+
+#include "hurricane/base/TupleSchema.h"
+
+namespace hurricane {
+    namespace base {
+        static const FixedValueCodec<bool, &Value::ToBoolean> BooleanCodec;
+        static const FixedValueCodec<char, &Value::ToCharacter> CharacterCodec;
+        static const FixedValueCodec<int8_t, &Value::ToInt8> Int8Codec;
+        static const FixedValueCodec<int16_t, &Value::ToInt16> Int16Codec;
+        static const FixedValueCodec<int32_t, &Value::ToInt32> Int32Codec;
+        static const FixedValueCodec<int64_t, &Value::ToInt64> Int64Codec;
+        static const FixedValueCodec<float, &Value::ToFloat> FloatCodec;
+        static const FixedValueCodec<double, &Value::ToDouble> DoubleCodec;
+        static const StringValueCodec StringCodec;
+
+        const ValueCodec* ValueCodec::GetCodec(Value::Type type) {
+            switch ( type ) {
+            case Value::Type::Boolean:
+                return &BooleanCodec;
+            case Value::Type::Character:
+                return &CharacterCodec;
+            case Value::Type::Int8:
+                return &Int8Codec;
+            case Value::Type::Int16:
+                return &Int16Codec;
+            case Value::Type::Int32:
+                return &Int32Codec;
+            case Value::Type::Int64:
+                return &Int64Codec;
+            case Value::Type::Float:
+                return &FloatCodec;
+            case Value::Type::Double:
+                return &DoubleCodec;
+            case Value::Type::String:
+                return &StringCodec;
+            default:
+                return nullptr;
+            }
+        }
+
+        TupleSchema::TupleSchema(const Fields& fields, const Values& values) :
+            _fields(fields) {
+            for ( const Value& value : values ) {
+                _types.push_back(value.GetType());
+            }
+
+            BuildCodecs();
+        }
+
+        bool TupleSchema::Accepts(const Values& values) const {
+            if ( values.size() != _types.size() ) {
+                return false;
+            }
+
+            for ( size_t fieldIndex = 0; fieldIndex != _types.size(); ++ fieldIndex ) {
+                if ( values[fieldIndex].GetType() != _types[fieldIndex] ) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        int32_t TupleSchema::GetSize(const Values& values) const {
+            int32_t size = 0;
+            for ( size_t fieldIndex = 0; fieldIndex != _codecs.size(); ++ fieldIndex ) {
+                size += _codecs[fieldIndex]->GetSize(values[fieldIndex]);
+            }
+
+            return size;
+        }
+
+        void TupleSchema::Encode(ByteArrayWriter& writer, const Values& values) const {
+            for ( size_t fieldIndex = 0; fieldIndex != _codecs.size(); ++ fieldIndex ) {
+                _codecs[fieldIndex]->Write(writer, values[fieldIndex]);
+            }
+        }
+
+        bool TupleSchema::Decode(ByteArrayReader& reader, Values& values) const {
+            values.resize(_codecs.size());
+            for ( size_t fieldIndex = 0; fieldIndex != _codecs.size(); ++ fieldIndex ) {
+                if ( !_codecs[fieldIndex]->Read(reader, values[fieldIndex]) ) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        Variants TupleSchema::ToVariants() const {
+            Variants variants;
+            for ( size_t fieldIndex = 0; fieldIndex != _types.size(); ++ fieldIndex ) {
+                std::string fieldName = fieldIndex < _fields.size() ? _fields[fieldIndex] : std::string();
+
+                variants.push_back(fieldName);
+                variants.push_back(static_cast<int32_t>(_types[fieldIndex]));
+            }
+
+            return variants;
+        }
+
+        TupleSchema TupleSchema::FromVariants(const Variants& variants, size_t offset) {
+            TupleSchema schema;
+            for ( size_t index = offset; index + 1 < variants.size(); index += 2 ) {
+                if ( variants[index].GetType() != Variant::Type::String ||
+                    variants[index + 1].GetType() != Variant::Type::Integer ) {
+                    return TupleSchema();
+                }
+
+                schema._fields.push_back(variants[index].GetStringValue());
+                schema._types.push_back(static_cast<Value::Type>(variants[index + 1].GetIntValue()));
+            }
+
+            schema.BuildCodecs();
+
+            return schema;
+        }
+
+        void TupleSchema::BuildCodecs() {
+            _codecs.clear();
+            for ( Value::Type type : _types ) {
+                const ValueCodec* codec = ValueCodec::GetCodec(type);
+                if ( !codec ) {
+                    // A field without a wire encoding makes the whole schema unusable
+                    _types.clear();
+                    _codecs.clear();
+
+                    return;
+                }
+
+                _codecs.push_back(codec);
+            }
+        }
+    }
+}
@@ -5,32 +5,55 @@
 namespace hurricane {
     namespace base {
 
+        // Every value type has a native wire encoding, so no value is widened or stringified
         Variant Value::ToVariant() const {
-            if ( _type == Type::Int8 ) {
-                return Variant(static_cast<int32_t>(ToInt8()));
-            }
-            else if ( _type == Type::Int16 ) {
-                return Variant(static_cast<int32_t>(ToInt16()));
-            }
-            else if ( _type == Type::Int32 ) {
+            switch ( _type ) {
+            case Type::Boolean:
+                return Variant(ToBoolean());
+            case Type::Character:
+                return Variant(ToCharacter());
+            case Type::Int8:
+                return Variant(ToInt8());
+            case Type::Int16:
+                return Variant(ToInt16());
+            case Type::Int32:
                 return Variant(ToInt32());
-            }
-            else if ( _type == Type::String ) {
+            case Type::Int64:
+                return Variant(ToInt64());
+            case Type::Float:
+                return Variant(ToFloat());
+            case Type::Double:
+                return Variant(ToDouble());
+            case Type::String:
                 return Variant(ToString());
+            default:
+                return Variant();
             }
-            
-            return Variant();
         }
 
         Value Value::FromVariant(const Variant& variant) {
-            if ( variant.GetType() == Variant::Type::Integer ) {
+            switch ( variant.GetType() ) {
+            case Variant::Type::Boolean:
+                return Value(variant.GetBooleanValue());
+            case Variant::Type::Character:
+                return Value(variant.GetCharacterValue());
+            case Variant::Type::Int8:
+                return Value(variant.GetInt8Value());
+            case Variant::Type::Int16:
+                return Value(variant.GetInt16Value());
+            case Variant::Type::Integer:
                 return Value(variant.GetIntValue());
-            }
-            else if ( variant.GetType() == Variant::Type::String ) {
+            case Variant::Type::Int64:
+                return Value(variant.GetInt64Value());
+            case Variant::Type::Float:
+                return Value(variant.GetFloatValue());
+            case Variant::Type::Double:
+                return Value(variant.GetDoubleValue());
+            case Variant::Type::String:
                 return Value(variant.GetStringValue());
+            default:
+                return Value();
             }
-
-            return Value();
         }
     }
 }
\ No newline at end of file
@@ -27,6 +27,9 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #ifdef WIN32
 #ifdef PostMessage
@@ -37,21 +40,147 @@
 namespace hurricane {
 
     namespace bolt {
-        BoltExecutor::BoltExecutor() : base::Executor<bolt::IBolt>() {
-            _messageLoop.MessageMap(BoltMessage::MessageType::Data,
-                this, &BoltExecutor::OnData);
+        typedef std::tuple<std::string, int, int> LocalExecutorKey;
+
+        static std::mutex LocalExecutorsMutex;
+        static std::map<LocalExecutorKey, BoltExecutor*> LocalExecutors;
+
+        const int64_t BoltExecutor::DEFAULT_HIGH_WATERMARK;
+        const int64_t BoltExecutor::DEFAULT_LOW_WATERMARK;
+        const int32_t BoltExecutor::DEFAULT_EXECUTE_BATCH_SIZE;
+
+        BoltExecutor::BoltExecutor() : base::Executor<bolt::IBolt>(), _destinationPending(false),
+            _executeBatchSize(DEFAULT_EXECUTE_BATCH_SIZE),
+            _highWatermark(DEFAULT_HIGH_WATERMARK), _lowWatermark(DEFAULT_LOW_WATERMARK),
+            _overloaded(false) {
+            _messageLoop.MessageMap<BoltExecutor, &BoltExecutor::OnData>(
+                BoltMessage::MessageType::Data, this);
+            // A partial batch is executed once the queue ran empty, so no tuple waits for more to arrive
+            _messageLoop.SetBatchEndHandler([this]() {
+                FlushBatch();
+            });
+        }
+
+        BoltExecutor::~BoltExecutor() {
+            std::unique_lock<std::mutex> locker(LocalExecutorsMutex);
+            for ( auto executorPair = LocalExecutors.begin(); executorPair != LocalExecutors.end(); ) {
+                if ( executorPair->second == this ) {
+                    executorPair = LocalExecutors.erase(executorPair);
+                }
+                else {
+                    ++ executorPair;
+                }
+            }
+        }
+
+        void BoltExecutor::SetLocalAddress(const base::NetAddress& address)
+        {
+            std::unique_lock<std::mutex> locker(LocalExecutorsMutex);
+            LocalExecutors[LocalExecutorKey(address.GetHost(), address.GetPort(), _executorIndex)] = this;
+        }
+
+        BoltExecutor* BoltExecutor::FindLocal(const base::NetAddress& address, int executorIndex)
+        {
+            std::unique_lock<std::mutex> locker(LocalExecutorsMutex);
+            auto executorPair = LocalExecutors.find(
+                LocalExecutorKey(address.GetHost(), address.GetPort(), executorIndex));
+            if ( executorPair == LocalExecutors.end() ) {
+                return nullptr;
+            }
+
+            return executorPair->second;
         }
 
         void BoltExecutor::SendData(const base::Values& values)
         {
-            _messageLoop.PostMessage(new BoltMessage(values));
+            SendData(base::Values(values));
+        }
+
+        void BoltExecutor::SendData(base::Values&& values, std::shared_ptr<std::atomic<int64_t>> pendingCount)
+        {
+            BoltMessage* message = _messagePool.Acquire();
+            message->SetValues(std::move(values));
+            message->SetPendingCount(std::move(pendingCount));
+
+            // Set before posting, so that the executor sees it when it drains the message
+            if ( !_overloaded && _messageLoop.GetPendingCount() + 1 >= _highWatermark ) {
+                _overloaded = true;
+            }
+
+            _messageLoop.PostMessage(message);
         }
 
         void BoltExecutor::OnData(hurricane::message::Message* message) {
-            BoltMessage* boltMessage = dynamic_cast<BoltMessage*>(message);
-            _task->Execute(boltMessage->GetValues());
+            // Only data messages are mapped to this handler
+            BoltMessage* boltMessage = static_cast<BoltMessage*>(message);
+            _batchValues.push_back(boltMessage->TakeValues());
+            _batchMessages.push_back(boltMessage);
+
+            if ( int32_t(_batchValues.size()) >= _executeBatchSize ) {
+                FlushBatch();
+            }
+        }
+
+        void BoltExecutor::FlushBatch() {
+            if ( _batchValues.empty() ) {
+                return;
+            }
+
+            // Tuples are left in the queue while the downstream executors are overloaded,
+            // so that the pressure reaches the executors sending to this one. A scheduled
+            // executor must not block its worker, it is only run once it is ready.
+            if ( _outputCollector && !IsScheduled() ) {
+                _outputCollector->WaitWhileThrottled();
+            }
 
-            delete message;
+            if ( _batchValues.size() == 1 ) {
+                _task->Execute(_batchValues.front());
+            }
+            else {
+                _task->ExecuteBatch(_batchValues);
+            }
+
+            for ( BoltMessage* boltMessage : _batchMessages ) {
+                boltMessage->Clear();
+                _messagePool.Release(boltMessage);
+            }
+            _batchValues.clear();
+            _batchMessages.clear();
+
+            // The message being handled may still be counted
+            if ( _overloaded && _messageLoop.GetPendingCount() <= _lowWatermark + 1 ) {
+                std::vector<CapacityHandler> capacityHandlers;
+                {
+                    std::unique_lock<std::mutex> locker(_capacityMutex);
+                    _overloaded = false;
+                    capacityHandlers.swap(_capacityHandlers);
+                }
+
+                for ( CapacityHandler& capacityHandler : capacityHandlers ) {
+                    capacityHandler();
+                }
+            }
+        }
+
+        bool BoltExecutor::OnCapacity(CapacityHandler handler)
+        {
+            std::unique_lock<std::mutex> locker(_capacityMutex);
+            if ( !_overloaded ) {
+                return false;
+            }
+
+            _capacityHandlers.push_back(handler);
+
+            return true;
+        }
+
+        bool BoltExecutor::IsReady()
+        {
+            if ( _destinationPending ) {
+                return false;
+            }
+
+            return !_outputCollector || !_outputCollector->IsThrottled();
         }
 
         void BoltExecutor::OnCreate()
@@ -59,10 +188,17 @@ namespace hurricane {
             std::cout << "Start Bolt Task" << std::endl;
 
             if ( _task->GetStrategy() == base::ITask::Strategy::Global ) {
-                BoltOutputCollector outputCollector(GetTaskName(), base::OutputCollector::Strategy::Global, this);
-                RandomDestination(&outputCollector);
+                _outputCollector = std::make_shared<BoltOutputCollector>(
+                    GetTaskName(), base::OutputCollector::Strategy::Global, this);
+                // A worker of the scheduler must not wait for the nimbus
+                if ( IsScheduled() ) {
+                    RandomDestinationAsync(_outputCollector);
+                }
+                else {
+                    RandomDestination(_outputCollector.get());
+                }
 
-                _task->Prepare(outputCollector);
+                _task->Prepare(*_outputCollector);
             }
         }
 
@@ -70,7 +206,11 @@ namespace hurricane {
         {
             std::cout << "Stop Bolt Task" << std::endl;
 
+            // The stop message ends the loop before the batch end
+            FlushBatch();
             _task->Cleanup();
+            // Sends the tuples still waiting in the batch
+            _outputCollector.reset();
         }
 
         void BoltExecutor::RandomDestination(BoltOutputCollector * outputCollector)
@@ -79,10 +219,32 @@ namespace hurricane {
             int32_t port;
             int32_t destIndex;
 
-            _commander->RandomDestination("bolt", _executorIndex, &host, &port, &destIndex);
-            outputCollector->SetCommander(new message::SupervisorCommander(
-                base::NetAddress(host, port), _commander->GetSupervisorName()));
-            outputCollector->SetTaskIndex(destIndex);
+            if ( !_commander->RandomDestination("bolt", _executorIndex, &host, &port, &destIndex) ) {
+                return;
+            }
+
+            outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                _commander->GetSupervisorName(), _task->DeclareFields(),
+                message::SupervisorCommander::DEFAULT_ACK_WINDOW_TUPLES);
+        }
+
+        void BoltExecutor::RandomDestinationAsync(std::shared_ptr<BoltOutputCollector> outputCollector)
+        {
+            _destinationPending = true;
+
+            // The callback runs on the io loop thread, it must not touch the task
+            std::string supervisorName = _commander->GetSupervisorName();
+            base::Fields fields = _task->DeclareFields();
+            _commander->RandomDestinationAsync("bolt", _executorIndex,
+                [this, outputCollector, supervisorName, fields](const std::string& host, int port, int destIndex) {
+                if ( destIndex >= 0 ) {
+                    outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                        supervisorName, fields, message::SupervisorCommander::DEFAULT_ACK_WINDOW_TUPLES);
+                }
+
+                _destinationPending = false;
+                Notify();
+            });
         }
 
         void BoltExecutor::GroupDestination(BoltOutputCollector * outputCollector, int fieldIndex)
@@ -91,11 +253,14 @@ namespace hurricane {
             int32_t port;
             int32_t destIndex;
 
-            _commander->GroupDestination("bolt", _executorIndex,
-                &host, &port, &destIndex, fieldIndex);
-            outputCollector->SetCommander(new message::SupervisorCommander(
-                base::NetAddress(host, port), _commander->GetSupervisorName()));
-            outputCollector->SetTaskIndex(destIndex);
+            if ( !_commander->GroupDestination("bolt", _executorIndex,
+                &host, &port, &destIndex, fieldIndex) ) {
+                return;
+            }
+
+            outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                _commander->GetSupervisorName(), _task->DeclareFields(),
+                message::SupervisorCommander::DEFAULT_ACK_WINDOW_TUPLES);
         }
 
     }
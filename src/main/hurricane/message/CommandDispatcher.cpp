@@ -21,10 +21,16 @@
 
 namespace hurricane {
 	namespace message {
-		void CommandDispatcher::Dispatch(const Command & command)
+		void CommandDispatcher::Dispatch(const Command & command, meshy::IStream* src)
 		{
-			Handler handler = _handlers[command.GetType()];
-			handler(command.GetArgs(), command.GetSrc());
+			_requestId = command.GetRequestId();
+
+			auto handler = _handlers.find(command.GetType());
+			if ( handler == _handlers.end() ) {
+				return;
+			}
+
+			handler->second(command.GetArgs(), src);
 		}
 	}
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include "hurricane/message/MessageLoop.h"
 #include "hurricane/message/Message.h"
 
+#ifdef WIN32
 #include <Windows.h>
 
 // Because Windows defined the PostMessage Macro
@@ -32,34 +33,208 @@ namespace hurricane {
 namespace message {
 	// 使用windows的PostThreadMessage向对应的线程投递消息,并在run函数的无限循环中使用GetMessage获取并解析消息,执行消息
 	// 如果接收到了Stop类型的消息,那么整个循环停止,消息队列结束
-	MessageLoop::MessageLoop() {
+	MessageLoop::MessageLoop() : _pendingCount(0) {
 		_threadId = GetCurrentThreadId();
 	}
 
+	MessageLoop::~MessageLoop() {
+	}
+
 	void MessageLoop::Run() {
 		MSG msg;
 
 		while ( GetMessage(&msg, 0, 0, 0) ) {
-			auto handler = _messageHandlers.find(msg.message);
-
-			if ( handler != _messageHandlers.end() ) {
-				handler->second((Message*)(msg.wParam));
-			}
+			int32_t messageType = int32_t(msg.message - WM_USER);
+			Dispatch(messageType, (Message*)(msg.wParam));
 
 			DispatchMessage(&msg);
+			_pendingCount --;
 
-			if ( msg.message == Message::Type::Stop ) {
+			if ( messageType == Message::Type::Stop ) {
 				break;
 			}
+
+			MSG nextMsg;
+			if ( _batchEndHandler && !PeekMessage(&nextMsg, 0, 0, 0, PM_NOREMOVE) ) {
+				_batchEndHandler();
+			}
+		}
+	}
+
+	void MessageLoop::PostMessage(Message* message) {
+		_pendingCount ++;
+		// The types below WM_USER are reserved by Windows
+		PostThreadMessage(_threadId, WM_USER + message->GetType(), WPARAM(message), 0);
+	}
+
+	void MessageLoop::Stop() {
+		PostMessage(new Message(Message::Type::Stop));
+	}
+}
+}
+
+#else
+
+#include "hurricane/base/IdleStrategy.h"
+
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace hurricane {
+namespace message {
+	const uint64_t MessageLoop::CAPACITY;
+	const int32_t MessageLoop::BATCH_SIZE;
+
+	MessageLoop::MessageLoop() : _cells(new Cell[CAPACITY]), _pushPosition(0), _popPosition(0),
+		_waiting(false), _pendingCount(0) {
+		for ( uint64_t position = 0; position < CAPACITY; position ++ ) {
+			_cells[position].sequence.store(position, std::memory_order_relaxed);
+		}
+
+		_eventfd = eventfd(0, EFD_CLOEXEC);
+	}
+
+	MessageLoop::~MessageLoop() {
+		Message* message;
+		while ( TryPop(&message) ) {
+			delete message;
+		}
+
+		close(_eventfd);
+	}
+
+	// Handles up to BATCH_SIZE messages before it checks whether it has to sleep,
+	// the eventfd is only touched when the queue ran empty
+	void MessageLoop::Run() {
+		while ( true ) {
+			Message* message = nullptr;
+			for ( int32_t handled = 0; handled < BATCH_SIZE && TryPop(&message); handled ++ ) {
+				if ( HandleMessage(message) ) {
+					return;
+				}
+			}
+
+			if ( _batchEndHandler ) {
+				_batchEndHandler();
+			}
+
+			WaitForMessage();
+		}
+	}
+
+	int32_t MessageLoop::Poll(int32_t maxMessages, bool* stopped) {
+		*stopped = false;
+
+		Message* message = nullptr;
+		int32_t handled = 0;
+		while ( handled < maxMessages && TryPop(&message) ) {
+			handled ++;
+
+			if ( HandleMessage(message) ) {
+				*stopped = true;
+				return handled;
+			}
+		}
+
+		if ( handled > 0 && _batchEndHandler ) {
+			_batchEndHandler();
+		}
+
+		return handled;
+	}
+
+	bool MessageLoop::HandleMessage(Message* message) {
+		int32_t messageType = message->GetType();
+		if ( !Dispatch(messageType, message) ) {
+			delete message;
 		}
+
+		_pendingCount --;
+
+		return messageType == Message::Type::Stop;
 	}
 
 	void MessageLoop::PostMessage(Message* message) {
-		PostThreadMessage(_threadId, message->GetType(), WPARAM(message), 0);
+		_pendingCount ++;
+
+		// The queue only fills up when the consumer is far behind, the producer backs off
+		base::IdleStrategy idleStrategy;
+		while ( !TryPush(message) ) {
+			idleStrategy.Idle();
+		}
+
+		if ( _wakeupHandler ) {
+			_wakeupHandler();
+			return;
+		}
+
+		// The push and _waiting are both sequentially consistent, so either the consumer sees
+		// the message before it sleeps or the producer sees it waiting
+		if ( _waiting.load() && _waiting.exchange(false) ) {
+			uint64_t value = 1;
+			ssize_t written = write(_eventfd, &value, sizeof(value));
+			(void)(written);
+		}
 	}
 
 	void MessageLoop::Stop() {
 		PostMessage(new Message(Message::Type::Stop));
 	}
+
+	bool MessageLoop::TryPush(Message* message) {
+		uint64_t position = _pushPosition.load(std::memory_order_relaxed);
+
+		while ( true ) {
+			Cell& cell = _cells[position & (CAPACITY - 1)];
+			uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+			if ( sequence == position ) {
+				if ( _pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) ) {
+					cell.message = message;
+					cell.sequence.store(position + 1);
+
+					return true;
+				}
+			}
+			else if ( sequence < position ) {
+				// The consumer did not free the cell yet, the ring is full
+				return false;
+			}
+			else {
+				position = _pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool MessageLoop::TryPop(Message** message) {
+		Cell& cell = _cells[_popPosition & (CAPACITY - 1)];
+		uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if ( sequence != _popPosition + 1 ) {
+			return false;
+		}
+
+		*message = cell.message;
+		cell.sequence.store(_popPosition + CAPACITY, std::memory_order_release);
+		_popPosition ++;
+
+		return true;
+	}
+
+	void MessageLoop::WaitForMessage() {
+		_waiting.store(true);
+
+		// A message pushed before _waiting was visible is seen here, later ones write the eventfd
+		Cell& cell = _cells[_popPosition & (CAPACITY - 1)];
+		if ( cell.sequence.load() == _popPosition + 1 ) {
+			_waiting.store(false, std::memory_order_relaxed);
+			return;
+		}
+
+		uint64_t value;
+		ssize_t readSize = read(_eventfd, &value, sizeof(value));
+		(void)(readSize);
+	}
 }
-}
\ No newline at end of file
+}
+
+#endif // WIN32
@@ -46,10 +46,12 @@ namespace hurricane {
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
 				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			std::cout << command.GetType() << std::endl;
@@ -69,15 +71,56 @@ namespace hurricane {
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
 				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			std::cout << command.GetType() << std::endl;
 			std::cout << command.GetArg(0).GetStringValue() << std::endl;
 		}
 
+		void NimbusCommander::StartSpoutAsync(const std::string& spoutName, int executorIndex,
+			ResponseCallback callback)
+		{
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::StartSpout, {
+				spoutName, executorIndex
+			}), callback);
+		}
+
+		void NimbusCommander::StartBoltAsync(const std::string& boltName, int executorIndex,
+			ResponseCallback callback)
+		{
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::StartBolt, {
+				boltName, executorIndex
+			}), callback);
+		}
+
+		void NimbusCommander::SendCommandAsync(const Command& command, ResponseCallback callback)
+		{
+			ByteArray message = command.ToDataPackage().Serialize();
+
+			_connector->SendRequest(message.data(), message.size(),
+				[callback](const char* buffer, int32_t size) {
+				if ( !buffer ) {
+					return;
+				}
+
+				DataPackage resultPackage;
+				resultPackage.Deserialize(buffer, size);
+
+				if ( callback ) {
+					callback(Command(resultPackage));
+				}
+			});
+		}
+
 	}
 }
\ No newline at end of file
@@ -23,6 +23,9 @@
 #include "hurricane/base/DataPackage.h"
 #include "hurricane/message/Command.h"
 
+#include <algorithm>
+#include <iostream>
+
 using hurricane::base::NetAddress;
 using hurricane::base::ByteArray;
 using hurricane::base::DataPackage;
@@ -32,6 +35,10 @@ const int DATA_BUFFER_SIZE = 65535;
 namespace hurricane {
 	namespace message {
 
+		const int32_t SupervisorCommander::DEFAULT_ACK_WINDOW_TUPLES;
+		const int32_t SupervisorCommander::DEFAULT_ACK_WINDOW_BYTES;
+		const int32_t SupervisorCommander::DEFAULT_ACK_TIMEOUT_MILLISECONDS;
+
 		void SupervisorCommander::Join() {
 			Connect();
 
@@ -39,15 +46,17 @@ namespace hurricane {
 				_supervisorName
 			});
 			DataPackage messagePackage = command.ToDataPackage();
-			ByteArray message = messagePackage.Serialize();
+			messagePackage.Serialize(_messageBuffer);
 
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
-				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			std::cout << command.GetType() << std::endl;
@@ -61,23 +70,46 @@ namespace hurricane {
 				_supervisorName
 			});
 			DataPackage messagePackage = command.ToDataPackage();
-			ByteArray message = messagePackage.Serialize();
+			messagePackage.Serialize(_messageBuffer);
 
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
-				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 		}
 
+		void SupervisorCommander::JoinAsync(ResponseCallback callback) {
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::Join, {
+				_supervisorName
+			}), callback);
+		}
+
+		void SupervisorCommander::AliveAsync(ResponseCallback callback) {
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::Alive, {
+				_supervisorName
+			}), callback);
+		}
+
 		void SupervisorCommander::SendTuple(int taskIndex,
 			const base::Values& values) {
 			Connect();
 
-			base::Variants args = { _supervisorName, _taskIndex };
+			if ( UseSchema(values) ) {
+				SendSchemaTuples(taskIndex, &values, 1);
+				return;
+			}
+
+			base::Variants args = { _supervisorName, taskIndex };
 			for ( const base::Value& value : values ) {
 				args.push_back(value.ToVariant());
 			}
@@ -85,21 +117,327 @@ namespace hurricane {
 			Command command(Command::Type::Data, args);
 
 			DataPackage messagePackage = command.ToDataPackage();
-			ByteArray message = messagePackage.Serialize();
+			messagePackage.Serialize(_messageBuffer);
+
+			if ( _ackWindowTuples > 0 || _ackWindowBytes > 0 ) {
+				SendTupleFrame(1);
+				return;
+			}
 
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
-				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			std::cout << command.GetType() << std::endl;
 			std::cout << command.GetArg(0).GetStringValue() << std::endl;
 		}
-		void SupervisorCommander::RandomDestination(const std::string srcType, int32_t srcIndex, 
+
+		// Tagged batches are laid out as
+		// [supervisorName, taskIndex, tupleCount, (valueCount, values...) * tupleCount]
+		void SupervisorCommander::SendTuples(int taskIndex,
+			const std::vector<base::Values>& tuples) {
+			if ( tuples.empty() ) {
+				return;
+			}
+
+			Connect();
+
+			if ( UseSchema(tuples.front()) ) {
+				bool accepted = true;
+				for ( const base::Values& values : tuples ) {
+					if ( !_schema.Accepts(values) ) {
+						accepted = false;
+						break;
+					}
+				}
+
+				if ( accepted ) {
+					SendSchemaTuples(taskIndex, tuples.data(), int32_t(tuples.size()));
+					return;
+				}
+			}
+
+			DataPackage messagePackage(DataPackage::Version::Compact);
+			messagePackage.AddVariant(int32_t(Command::Type::BatchData));
+			messagePackage.AddVariant(_supervisorName);
+			messagePackage.AddVariant(int32_t(taskIndex));
+			messagePackage.AddVariant(int32_t(tuples.size()));
+			for ( const base::Values& values : tuples ) {
+				messagePackage.AddVariant(int32_t(values.size()));
+				for ( const base::Value& value : values ) {
+					messagePackage.AddVariant(value.ToVariant());
+				}
+			}
+			messagePackage.Serialize(_messageBuffer);
+
+			SendTupleFrame(int32_t(tuples.size()));
+		}
+
+		bool SupervisorCommander::UseSchema(const base::Values& values) {
+			if ( _schemaFields.empty() ) {
+				return false;
+			}
+
+			if ( !_schemaDeclared ) {
+				DeclareSchema(values);
+			}
+
+			return !_schema.IsEmpty() && _schema.Accepts(values);
+		}
+
+		void SupervisorCommander::DeclareSchema(const base::Values& values) {
+			_schemaDeclared = true;
+			_schema = base::TupleSchema(_schemaFields, values);
+			if ( _schema.IsEmpty() ) {
+				return;
+			}
+
+			SendSchemaDeclaration();
+		}
+
+		void SupervisorCommander::SendSchemaDeclaration() {
+			base::Variants args = { _supervisorName };
+			base::Variants schemaArgs = _schema.ToVariants();
+			args.insert(args.end(), schemaArgs.begin(), schemaArgs.end());
+
+			Command command(Command::Type::Schema, args);
+
+			DataPackage messagePackage = command.ToDataPackage();
+			messagePackage.Serialize(_messageBuffer);
+
+			SendMessageBuffer();
+		}
+
+		// The frame only carries the command type, the task index and the tuple count as tagged variants,
+		// the values follow untagged in the order of the schema declared on this connection.
+		void SupervisorCommander::SendSchemaTuples(int taskIndex,
+			const base::Values* tuples, int32_t tupleCount) {
+			DataPackage messagePackage(DataPackage::Version::Compact);
+			messagePackage.AddVariant(int32_t(Command::Type::SchemaData));
+			messagePackage.AddVariant(int32_t(taskIndex));
+			messagePackage.AddVariant(tupleCount);
+			messagePackage.Serialize(_messageBuffer, [this, tuples, tupleCount](base::ByteArrayWriter& writer) {
+				int32_t tailSize = 0;
+				for ( int32_t tupleIndex = 0; tupleIndex < tupleCount; tupleIndex ++ ) {
+					tailSize += _schema.GetSize(tuples[tupleIndex]);
+				}
+
+				writer.Reserve(writer.Tell() + tailSize);
+				for ( int32_t tupleIndex = 0; tupleIndex < tupleCount; tupleIndex ++ ) {
+					_schema.Encode(writer, tuples[tupleIndex]);
+				}
+			});
+
+			SendTupleFrame(tupleCount);
+		}
+
+		void SupervisorCommander::SendTupleFrame(int32_t tupleCount) {
+			if ( _ackWindowTuples <= 0 && _ackWindowBytes <= 0 ) {
+				SendMessageBuffer();
+				return;
+			}
+
+			int32_t size = int32_t(_messageBuffer.size());
+			int64_t sequence = 0;
+			int64_t generation = 0;
+			bool requestAck = false;
+			{
+				std::unique_lock<std::mutex> locker(_ackMutex);
+				// The frames of a closed or stalled connection are retransmitted on a new one once,
+				// if that does not help either they are given up
+				bool reconnected = false;
+				while ( !WaitForAckWindow(locker) ) {
+					if ( !reconnected ) {
+						// Declaring the schema again reuses the message buffer
+						base::ByteArray frame;
+						frame.swap(_messageBuffer);
+						locker.unlock();
+						Reconnect();
+						locker.lock();
+						_messageBuffer.swap(frame);
+						reconnected = true;
+					}
+					else {
+						std::cerr << "Giving up " << _unackedTuples << " unacknowledged tuples" << std::endl;
+						DropUnackedFrames();
+					}
+				}
+
+				sequence = ++ _sentSequence;
+				generation = _connectionGeneration;
+				UnackedFrame unackedFrame = { sequence, tupleCount, size,
+					std::chrono::steady_clock::now(), base::ByteArray() };
+				if ( _retransmitOnReconnect ) {
+					unackedFrame.frame = _messageBuffer;
+				}
+				_unackedFrames.push_back(unackedFrame);
+
+				_unackedTuples += tupleCount;
+				_unackedBytes += size;
+				_unrequestedTuples += tupleCount;
+				_unrequestedBytes += size;
+
+				// Asking every half window keeps acknowledgements arriving before the window fills up
+				requestAck = ( _ackWindowTuples > 0 && _unrequestedTuples >= std::max(_ackWindowTuples / 2, 1) ) ||
+					( _ackWindowBytes > 0 && _unrequestedBytes >= std::max(_ackWindowBytes / 2, 1) );
+				if ( requestAck ) {
+					_unrequestedTuples = 0;
+					_unrequestedBytes = 0;
+				}
+			}
+
+			if ( requestAck ) {
+				_connector->SendRequest(_messageBuffer.data(), size, [this, sequence, generation](const char* frame, int32_t) {
+					if ( frame ) {
+						Acknowledge(sequence);
+					}
+					else {
+						FailAcknowledgements(generation);
+					}
+				});
+			}
+			else {
+				_connector->Send(_messageBuffer.data(), size);
+			}
+		}
+
+		// Called on the io loop thread, the frames are processed in order so the response to
+		// a frame acknowledges every frame before it as well
+		void SupervisorCommander::Acknowledge(int64_t sequence) {
+			std::unique_lock<std::mutex> locker(_ackMutex);
+			while ( !_unackedFrames.empty() && _unackedFrames.front().sequence <= sequence ) {
+				_unackedTuples -= _unackedFrames.front().tupleCount;
+				_unackedBytes -= _unackedFrames.front().size;
+				_unackedFrames.pop_front();
+			}
+
+			_ackCondition.notify_all();
+		}
+
+		void SupervisorCommander::FailAcknowledgements(int64_t generation) {
+			std::unique_lock<std::mutex> locker(_ackMutex);
+			if ( generation != _connectionGeneration ) {
+				return;
+			}
+
+			_connectionFailed = true;
+			_ackCondition.notify_all();
+		}
+
+		bool SupervisorCommander::WaitForAckWindow(std::unique_lock<std::mutex>& locker) {
+			while ( IsAckWindowFull() ) {
+				if ( _connectionFailed ) {
+					return false;
+				}
+
+				// The oldest frame is the one the acknowledgement is overdue for
+				std::chrono::steady_clock::time_point deadline = _unackedFrames.front().sentTime + _ackTimeout;
+				if ( std::chrono::steady_clock::now() >= deadline ) {
+					return false;
+				}
+
+				_ackCondition.wait_until(locker, deadline);
+			}
+
+			return true;
+		}
+
+		void SupervisorCommander::DropUnackedFrames() {
+			_unackedFrames.clear();
+			_unackedTuples = 0;
+			_unackedBytes = 0;
+			_ackCondition.notify_all();
+		}
+
+		bool SupervisorCommander::IsAckWindowOpen() {
+			std::unique_lock<std::mutex> locker(_ackMutex);
+			if ( !IsAckWindowFull() || _connectionFailed ) {
+				return true;
+			}
+
+			return std::chrono::steady_clock::now() >= _unackedFrames.front().sentTime + _ackTimeout;
+		}
+
+		bool SupervisorCommander::IsAckWindowFull() const {
+			return ( _ackWindowTuples > 0 && _unackedTuples >= _ackWindowTuples ) ||
+				( _ackWindowBytes > 0 && _unackedBytes >= _ackWindowBytes );
+		}
+
+		void SupervisorCommander::Reconnect() {
+			// The io loop only holds the old connector weakly, releasing it closes the old
+			// connection and its late responses are dropped
+			_connector.reset();
+			Connect();
+
+			if ( _schemaDeclared && !_schema.IsEmpty() ) {
+				SendSchemaDeclaration();
+			}
+
+			std::vector<UnackedFrame> retransmittedFrames;
+			int64_t generation = 0;
+			{
+				std::unique_lock<std::mutex> locker(_ackMutex);
+				_unrequestedTuples = 0;
+				_unrequestedBytes = 0;
+				generation = ++ _connectionGeneration;
+				_connectionFailed = false;
+
+				if ( !_retransmitOnReconnect ) {
+					DropUnackedFrames();
+					return;
+				}
+
+				// The acknowledgement timeout starts again on the new connection
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				for ( UnackedFrame& unackedFrame : _unackedFrames ) {
+					unackedFrame.sentTime = now;
+				}
+
+				// Sending may block on the socket, the acknowledgements must not wait for it
+				retransmittedFrames.assign(_unackedFrames.begin(), _unackedFrames.end());
+			}
+
+			// The last retransmitted frame asks for the acknowledgement of all of them
+			for ( size_t frameIndex = 0; frameIndex < retransmittedFrames.size(); frameIndex ++ ) {
+				UnackedFrame& unackedFrame = retransmittedFrames[frameIndex];
+				if ( frameIndex + 1 < retransmittedFrames.size() ) {
+					_connector->Send(unackedFrame.frame.data(), unackedFrame.size);
+				}
+				else {
+					int64_t sequence = unackedFrame.sequence;
+					_connector->SendRequest(unackedFrame.frame.data(), unackedFrame.size, [this, sequence, generation](const char* frame, int32_t) {
+						if ( frame ) {
+							Acknowledge(sequence);
+						}
+						else {
+							FailAcknowledgements(generation);
+						}
+					});
+				}
+			}
+		}
+
+		void SupervisorCommander::SendMessageBuffer() {
+			char resultBuffer[DATA_BUFFER_SIZE];
+			int32_t resultSize =
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return;
+			}
+
+			DataPackage resultPackage;
+			resultPackage.Deserialize(resultBuffer, resultSize);
+			Command command(resultPackage);
+		}
+
+		bool SupervisorCommander::RandomDestination(const std::string srcType, int32_t srcIndex, 
 			std::string * host, int * port, int* destIndex)
 		{
 			Connect();
@@ -108,46 +446,112 @@ namespace hurricane {
 				_supervisorName, srcType, srcIndex
 			});
 			DataPackage messagePackage = command.ToDataPackage();
-			ByteArray message = messagePackage.Serialize();
+			messagePackage.Serialize(_messageBuffer);
 
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
-				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return false;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			*host = command.GetArg(1).GetStringValue();
 			*port = command.GetArg(2).GetIntValue();
 			*destIndex = command.GetArg(3).GetIntValue();
+
+			return true;
 		}
 
-		void SupervisorCommander::GroupDestination(const std::string srcType, int srcIndex, 
+		bool SupervisorCommander::GroupDestination(const std::string srcType, int srcIndex, 
 				std::string * host, int * port, int * destIndex,
 				int fieldIndex)
 		{
 			Connect();
 
-			Command command(Command::Type::RandomDestination, {
+			Command command(Command::Type::GroupDestination, {
 				_supervisorName, srcType, srcIndex, fieldIndex
 			});
 			DataPackage messagePackage = command.ToDataPackage();
-			ByteArray message = messagePackage.Serialize();
+			messagePackage.Serialize(_messageBuffer);
 
 			char resultBuffer[DATA_BUFFER_SIZE];
 			int32_t resultSize =
-				_connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
+				_connector->SendAndReceive(_messageBuffer.data(), _messageBuffer.size(), resultBuffer, DATA_BUFFER_SIZE);
+			if ( resultSize < 0 ) {
+				return false;
+			}
 
-			ByteArray result(resultBuffer, resultSize);
 			DataPackage resultPackage;
-			resultPackage.Deserialize(result);
+			resultPackage.Deserialize(resultBuffer, resultSize);
 			command = Command(resultPackage);
 
 			*host = command.GetArg(1).GetStringValue();
 			*port = command.GetArg(2).GetIntValue();
 			*destIndex = command.GetArg(3).GetIntValue();
+
+			return true;
+		}
+
+		void SupervisorCommander::RandomDestinationAsync(const std::string& srcType, int32_t srcIndex,
+			DestinationCallback callback)
+		{
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::RandomDestination, {
+				_supervisorName, srcType, srcIndex
+			}), [callback](const Command& response) {
+				if ( response.GetType() == Command::Type::Invalid ) {
+					callback(std::string(), 0, -1);
+					return;
+				}
+
+				callback(response.GetArg(1).GetStringValue(),
+					response.GetArg(2).GetIntValue(), response.GetArg(3).GetIntValue());
+			});
+		}
+
+		void SupervisorCommander::GroupDestinationAsync(const std::string& srcType, int srcIndex, int fieldIndex,
+			DestinationCallback callback)
+		{
+			Connect();
+
+			SendCommandAsync(Command(Command::Type::GroupDestination, {
+				_supervisorName, srcType, srcIndex, fieldIndex
+			}), [callback](const Command& response) {
+				if ( response.GetType() == Command::Type::Invalid ) {
+					callback(std::string(), 0, -1);
+					return;
+				}
+
+				callback(response.GetArg(1).GetStringValue(),
+					response.GetArg(2).GetIntValue(), response.GetArg(3).GetIntValue());
+			});
+		}
+
+		void SupervisorCommander::SendCommandAsync(const Command& command, ResponseCallback callback)
+		{
+			DataPackage messagePackage = command.ToDataPackage();
+			messagePackage.Serialize(_messageBuffer);
+
+			_connector->SendRequest(_messageBuffer.data(), _messageBuffer.size(),
+				[callback](const char* buffer, int32_t size) {
+				if ( !callback ) {
+					return;
+				}
+
+				if ( !buffer ) {
+					callback(Command());
+					return;
+				}
+
+				DataPackage resultPackage;
+				resultPackage.Deserialize(buffer, size);
+				callback(Command(resultPackage));
+			});
 		}
 	}
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include "hurricane/spout/SpoutExecutor.h"
 #include "hurricane/base/OutputCollector.h"
 #include "hurricane/message/SupervisorCommander.h"
+#include "hurricane/base/IdleStrategy.h"
 #include "hurricane/spout/SpoutOutputCollector.h"
 
 #include <iostream>
@@ -27,6 +28,9 @@
 
 namespace hurricane {
     namespace spout {
+        const int64_t SpoutExecutor::DEFAULT_MAX_PENDING;
+        const int32_t SpoutExecutor::EXECUTE_BATCH_SIZE;
+
         void SpoutExecutor::StopTask()
         {
             _needToStop = true;
@@ -38,21 +42,74 @@ namespace hurricane {
             _needToStop = false;
 
             if ( _task->GetStrategy() == base::ITask::Strategy::Global ) {
-                SpoutOutputCollector outputCollector(GetTaskName(), base::ITask::Strategy::Global, this);
-                RandomDestination(&outputCollector);
+                _outputCollector = std::make_shared<SpoutOutputCollector>(
+                    GetTaskName(), base::ITask::Strategy::Global, this);
+                // A worker of the scheduler must not wait for the nimbus
+                if ( IsScheduled() ) {
+                    RandomDestinationAsync(_outputCollector);
+                }
+                else {
+                    RandomDestination(_outputCollector.get());
+                }
 
-                _task->Open(outputCollector);
+                _task->Open(*_outputCollector);
             }
 
-            while ( !_needToStop ) {
-                _task->Execute();
+            // A scheduled spout is executed from OnIdle
+            if ( IsScheduled() ) {
+                return;
             }
 
-            _task->Close();
+            // The executor paces the spout, a spout with nothing to emit returns from Execute at once
+            base::IdleStrategy idleStrategy;
+            while ( !_needToStop ) {
+                if ( ExecuteOnce() ) {
+                    idleStrategy.Reset();
+                }
+                else {
+                    idleStrategy.Idle();
+                }
+            }
         }
 
         void SpoutExecutor::OnStop() {
             std::cout << "Stop Spout Task" << std::endl;
+
+            _task->Close();
+            // Sends the tuples still waiting in the batch
+            _outputCollector.reset();
+        }
+
+        bool SpoutExecutor::IsReady() {
+            return !_destinationPending;
+        }
+
+        int32_t SpoutExecutor::OnIdle(std::chrono::microseconds* delay) {
+            for ( int32_t executed = 0; executed < EXECUTE_BATCH_SIZE && !_needToStop; executed ++ ) {
+                if ( !ExecuteOnce() ) {
+                    *delay = NextIdleDelay();
+                    return Result::Delay;
+                }
+
+                ResetIdleDelay();
+            }
+
+            // The stop message wakes the executor up again
+            return _needToStop ? Result::Wait : Result::Continue;
+        }
+
+        bool SpoutExecutor::ExecuteOnce() {
+            // Execute is paused while the downstream executors or connections are overloaded
+            // and while too many tuples wait for their acknowledgement
+            if ( _outputCollector && ( _outputCollector->IsThrottled() ||
+                ( _maxPending > 0 && _outputCollector->GetPendingCount() >= _maxPending ) ) ) {
+                return false;
+            }
+
+            uint64_t emittedCount = _outputCollector ? _outputCollector->GetEmittedCount() : 0;
+            _task->Execute();
+
+            return !_outputCollector || _outputCollector->GetEmittedCount() != emittedCount;
         }
 
         void SpoutExecutor::SetCommander(message::SupervisorCommander * commander)
@@ -60,16 +117,51 @@ namespace hurricane {
             _commander = commander;
         }
 
+        int32_t SpoutExecutor::GetAckWindowTuples() const
+        {
+            // Acknowledgements are only asked for every half window, a larger window
+            // would keep the pending tuples of a smaller limit from ever being acknowledged
+            int32_t windowTuples = message::SupervisorCommander::DEFAULT_ACK_WINDOW_TUPLES;
+            if ( _maxPending > 0 && _maxPending < windowTuples ) {
+                windowTuples = int32_t(_maxPending);
+            }
+
+            return windowTuples;
+        }
+
         void SpoutExecutor::RandomDestination(SpoutOutputCollector * outputCollector)
         {
             std::string host;
             int32_t port;
             int32_t destIndex;
 
-            _commander->RandomDestination("spout", _executorIndex, &host, &port, &destIndex);
-            outputCollector->SetCommander(new message::SupervisorCommander(
-                base::NetAddress(host, port), _commander->GetSupervisorName()));
-            outputCollector->SetTaskIndex(destIndex);
+            if ( !_commander->RandomDestination("spout", _executorIndex, &host, &port, &destIndex) ) {
+                return;
+            }
+
+            outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                _commander->GetSupervisorName(), _task->DeclareFields(), GetAckWindowTuples());
+        }
+
+        void SpoutExecutor::RandomDestinationAsync(std::shared_ptr<SpoutOutputCollector> outputCollector)
+        {
+            _destinationPending = true;
+
+            // The callback runs on the io loop thread, it must not touch the task
+            std::string supervisorName = _commander->GetSupervisorName();
+            base::Fields fields = _task->DeclareFields();
+            int32_t ackWindowTuples = GetAckWindowTuples();
+            _commander->RandomDestinationAsync("spout", _executorIndex,
+                [this, outputCollector, supervisorName, fields, ackWindowTuples](const std::string& host,
+                    int port, int destIndex) {
+                if ( destIndex >= 0 ) {
+                    outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                        supervisorName, fields, ackWindowTuples);
+                }
+
+                _destinationPending = false;
+                Notify();
+            });
         }
 
         void SpoutExecutor::GroupDestination(SpoutOutputCollector * outputCollector, int fieldIndex)
@@ -78,11 +170,13 @@ namespace hurricane {
             int32_t port;
             int32_t destIndex;
 
-            _commander->GroupDestination("spout", _executorIndex, 
-                &host, &port, &destIndex, fieldIndex);
-            outputCollector->SetCommander(new message::SupervisorCommander(
-                base::NetAddress(host, port), _commander->GetSupervisorName()));
-            outputCollector->SetTaskIndex(destIndex);
+            if ( !_commander->GroupDestination("spout", _executorIndex,
+                &host, &port, &destIndex, fieldIndex) ) {
+                return;
+            }
+
+            outputCollector->SetDestination(base::NetAddress(host, port), destIndex,
+                _commander->GetSupervisorName(), _task->DeclareFields(), GetAckWindowTuples());
         }
     }
 }
\ No newline at end of file
@@ -46,9 +46,8 @@ namespace hurricane {
             int32_t resultSize =
                 _connector->SendAndReceive(message.data(), message.size(), resultBuffer, DATA_BUFFER_SIZE);
 
-            ByteArray result(resultBuffer, resultSize);
             DataPackage resultPackage;
-            resultPackage.Deserialize(result);
+            resultPackage.Deserialize(resultBuffer, resultSize);
             command = Command(resultPackage);
 
             std::cout << command.GetType() << std::endl;
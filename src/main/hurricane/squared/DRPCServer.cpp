@@ -52,7 +52,7 @@ int main() {
     
     dispatcher
         .OnCommand(Command::Type::Join,
-            [&](hurricane::base::Variants args, std::shared_ptr<TcpConnection> src) -> void {
+            [&](hurricane::base::Variants args, meshy::IStream* src) -> void {
         std::string serviceName = args[0].GetStringValue();
         args.pop_front();
         std::string serviceArgs = args;
@@ -63,6 +63,7 @@ int main() {
         Command command(Command::Type::Response, {
             result
         });
+        command.SetRequestId(dispatcher.GetRequestId());
 
         ByteArray commandBytes = command.ToDataPackage().Serialize();
         src->Send(commandBytes.data(), commandBytes.size());
@@ -70,14 +71,13 @@ int main() {
 
     netListener.OnData([&](std::shared_ptr<TcpConnection> connection,
         const char* buffer, int32_t size) -> void {
-        ByteArray receivedData(buffer, size);
         DataPackage receivedPackage;
-        receivedPackage.Deserialize(receivedData);
+        receivedPackage.Deserialize(buffer, size);
 
         Command command(receivedPackage);
         command.SetSrc(connection);
 
-        dispatcher.Dispatch(command);
+        dispatcher.Dispatch(command, connection.get());
     });
 
     netListener.StartListen();
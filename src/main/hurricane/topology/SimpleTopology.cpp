@@ -28,7 +28,7 @@
 namespace hurricane {
 namespace topology {
 
-SimpleTopology::SimpleTopology() {
+SimpleTopology::SimpleTopology() : _placementPolicy(base::Placement::Policy::None) {
 }
 
 void SimpleTopology::SetSpouts(std::map<std::string, std::shared_ptr<spout::ISpout>> spouts) {
@@ -49,6 +49,15 @@ void SimpleTopology::EmitFrom(const std::string& src, const base::Values& values
 void SimpleTopology::Start() {
 }
 
+int64_t SimpleTopology::GetMaxPending(const std::string& spoutName) const {
+    auto maxPending = _maxPending.find(spoutName);
+    if ( maxPending == _maxPending.end() ) {
+        return 0;
+    }
+
+    return maxPending->second;
+}
+
 const std::map<std::string, std::shared_ptr<spout::ISpout>>& SimpleTopology::GetSpouts() const
 {
 	return _spouts;
@@ -41,11 +41,21 @@ void TopologyBuilder::SetBolt(const std::string& name, bolt::IBolt* bolt, const
     desinations->second.push_back(name);
 }
 
+void TopologyBuilder::SetPlacementPolicy(int32_t placementPolicy) {
+    _placementPolicy = placementPolicy;
+}
+
+void TopologyBuilder::SetMaxPending(const std::string& spoutName, int64_t maxPending) {
+    _maxPending[spoutName] = maxPending;
+}
+
 SimpleTopology* TopologyBuilder::Build() {
     SimpleTopology* topology = new SimpleTopology;
     topology->SetSpouts(_spouts);
     topology->SetBolts(_bolts);
     topology->SetNetwork(_network);
+    topology->SetPlacementPolicy(_placementPolicy);
+    topology->SetMaxPending(_maxPending);
 
     return topology;
 }
@@ -54,14 +54,20 @@ public:
 
     void Open(OutputCollector& outputCollector) override {
         _outputCollector = &outputCollector;
+        _nextEmitTime = std::chrono::steady_clock::now();
     }
 
     void Close() override {
     }
 
+    // Returns at once when there is nothing to emit yet, the executor backs off on its own
     void Execute() override {
+        if ( std::chrono::steady_clock::now() < _nextEmitTime ) {
+            return;
+        }
+
+        _nextEmitTime += std::chrono::milliseconds(1000);
         _outputCollector->Emit({ "The cBioPortal for Cancer Genomics provides visualization, analysis, and download of large-scale cancer genomics data sets. The cBioPortal is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public License, version 3, as published by the Free Software Foundation" });
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
 
     Fields DeclareFields() const override {
@@ -70,6 +76,7 @@ public:
 
 private:
     OutputCollector* _outputCollector;
+    std::chrono::steady_clock::time_point _nextEmitTime;
 };
 
 // 单词分割